@@ -0,0 +1,107 @@
+#include <cstring>
+
+#include "command.h"
+
+namespace {
+const char hex_digits[] = "0123456789ABCDEF";
+}
+
+void CSkCommand::append(std::vector<char> &out, const char *str, size_t length)
+{
+    // not insert(): gcc 12 at -O2 misreads its reallocation path after
+    // clear() as an overflow (-Warray-bounds, -Wstringop-overflow)
+    const size_t pos = out.size();
+    out.resize(pos + length);
+    std::memcpy(out.data() + pos, str, length);
+}
+
+void CSkCommand::append_hex(std::vector<char> &out, uint32_t value, int digits)
+{
+    for (int i = digits - 1; i >= 0; --i) {
+        out.push_back(hex_digits[(value >> (i * 4)) & 0x0F]);
+    }
+}
+
+void CSkCommand::append_ipv6(std::vector<char> &out, const node_addr_t &addr)
+{
+    for (int i = 0; i < 16; i += 2) {
+        if (i != 0) {
+            out.push_back(':');
+        }
+        append_hex(out, addr[i], 2);
+        append_hex(out, addr[i + 1], 2);
+    }
+}
+
+void CSkCommand::sendto(std::vector<char> &out, uint8_t handle, const node_addr_t &addr, uint16_t port, uint8_t sec,
+                        const uint8_t *data, size_t length)
+{
+    out.clear();
+    append(out, "SKSENDTO ");
+    append_hex(out, handle, 1);
+    out.push_back(' ');
+    append_ipv6(out, addr);
+    out.push_back(' ');
+    append_hex(out, port, 4);
+    out.push_back(' ');
+    append_hex(out, sec, 1);
+    out.push_back(' ');
+    append_hex(out, (uint32_t)length, 4);
+    out.push_back(' ');
+    out.insert(out.end(), (const char *)data, (const char *)data + length);
+}
+
+void CSkCommand::simple(std::vector<char> &out, const char *name)
+{
+    out.clear();
+    append_str(out, name);
+    append(out, "\r\n");
+}
+
+void CSkCommand::setpwd(std::vector<char> &out, const char *password)
+{
+    out.clear();
+    append(out, "SKSETPWD ");
+    append_hex(out, (uint32_t)std::strlen(password), 1);
+    out.push_back(' ');
+    append_str(out, password);
+    append(out, "\r\n");
+}
+
+void CSkCommand::setrbid(std::vector<char> &out, const char *id)
+{
+    out.clear();
+    append(out, "SKSETRBID ");
+    append_str(out, id);
+    append(out, "\r\n");
+}
+
+void CSkCommand::scan(std::vector<char> &out, uint8_t mode, uint32_t channel_mask, uint8_t duration)
+{
+    out.clear();
+    append(out, "SKSCAN ");
+    append_hex(out, mode, 1);
+    out.push_back(' ');
+    append_hex(out, channel_mask, 8);
+    out.push_back(' ');
+    append_hex(out, duration, 1);
+    append(out, "\r\n");
+}
+
+void CSkCommand::sreg(std::vector<char> &out, const char *reg, uint32_t value, int digits)
+{
+    out.clear();
+    append(out, "SKSREG ");
+    append_str(out, reg);
+    out.push_back(' ');
+    append_hex(out, value, digits);
+    append(out, "\r\n");
+}
+
+void CSkCommand::join(std::vector<char> &out, const node_addr_t &addr)
+{
+    out.clear();
+    append(out, "SKJOIN ");
+    append_ipv6(out, addr);
+    append(out, "\r\n");
+}
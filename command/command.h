@@ -0,0 +1,70 @@
+#ifndef _COMMAND_COMMAND_H_
+#define _COMMAND_COMMAND_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../echonet/echonet.h"
+
+/*
+  builders for SKSTACK command lines.
+  the caller owns the buffer so it can be reused between commands.
+ */
+class CSkCommand
+{
+public:
+    enum {
+        SEC_PLAIN   = 0,
+        SEC_ENCRYPT = 1,
+    };
+
+    // SKSENDTO <HANDLE> <IPADDR> <PORT> <SEC> <DATALEN> <DATA>
+    // DATA is written as is and is not followed by CRLF
+    static void sendto(std::vector<char> &out, uint8_t handle, const node_addr_t &addr, uint16_t port, uint8_t sec,
+                       const uint8_t *data, size_t length);
+
+    static void sendto(std::vector<char> &out, uint8_t handle, const node_addr_t &addr, uint16_t port, uint8_t sec,
+                       const std::vector<uint8_t> &data)
+    {
+        sendto(out, handle, addr, port, sec, data.data(), data.size());
+    }
+
+    // <NAME>\r\n, e.g. SKVER, SKTERM
+    static void simple(std::vector<char> &out, const char *name);
+
+    // SKSETPWD <LEN> <PWD>
+    static void setpwd(std::vector<char> &out, const char *password);
+
+    // SKSETRBID <ID>
+    static void setrbid(std::vector<char> &out, const char *id);
+
+    // SKSCAN <MODE> <CHANNEL_MASK> <DURATION>
+    static void scan(std::vector<char> &out, uint8_t mode, uint32_t channel_mask, uint8_t duration);
+
+    // SKSREG <SREG> <VAL>
+    static void sreg(std::vector<char> &out, const char *reg, uint32_t value, int digits);
+
+    // SKJOIN <IPADDR>
+    static void join(std::vector<char> &out, const node_addr_t &addr);
+
+    static void append(std::vector<char> &out, const char *str, size_t length);
+
+    // literals are appended with their length known at compile time
+    template <size_t size>
+    static void append(std::vector<char> &out, const char (&str)[size])
+    {
+        append(out, str, size - 1);
+    }
+
+    static void append_str(std::vector<char> &out, const char *str)
+    {
+        append(out, str, std::strlen(str));
+    }
+
+    static void append_hex(std::vector<char> &out, uint32_t value, int digits);
+    static void append_ipv6(std::vector<char> &out, const node_addr_t &addr);
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include <algorithm>
+#include <set>
+#include <time.h>
+
+#include "backfill.h"
+
+namespace {
+
+const int64_t SLOT = CIntervalStore::SLOT_SECONDS;
+const int64_t DAY = 24 * 60 * 60;
+const int DAY_POINTS = 48;
+
+uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// the meter counts in local time
+int64_t local_midnight(int64_t t)
+{
+    time_t tt = (time_t)t;
+    struct tm tm;
+    localtime_r(&tt, &tm);
+    tm.tm_hour = 0;
+    tm.tm_min = 0;
+    tm.tm_sec = 0;
+    tm.tm_isdst = -1;
+    return (int64_t)mktime(&tm);
+}
+
+const CEchonetProperty *find_property(const CEchonetFrame &frame, uint8_t epc)
+{
+    for (size_t i = frame.set_count; i < frame.properties.size(); ++i) {
+        if (frame.properties[i].epc == epc) {
+            return &frame.properties[i];
+        }
+    }
+    return nullptr;
+}
+
+}
+
+size_t CBackfillJob::plan(int64_t from, int64_t to, int64_t now)
+{
+    _today = local_midnight(now);
+    const int64_t oldest = _today - (int64_t)MAX_HISTORY_DAYS * DAY;
+    from = std::max(from, oldest);
+    to = std::min(to, now - now % SLOT);
+    if (from >= to) {
+        return 0;
+    }
+
+    CIntervalStore::gap_list gaps;
+    _store.find_gaps(from, to, gaps);
+
+    size_t planned = 0;
+    if (_mode == BACKFILL_DAY_HISTORY) {
+        std::set<int> days;
+        for (const auto &gap : gaps) {
+            for (int64_t day_start = local_midnight(gap.first); day_start < gap.second; day_start = local_midnight(day_start + DAY + DAY / 2)) {
+                days.insert((int)((_today - day_start + DAY / 2) / DAY));
+            }
+        }
+        for (int day : days) {
+            _queue.push_back(CStep { day, 0, 0, 0 });
+            ++planned;
+        }
+    } else {
+        for (const auto &gap : gaps) {
+            // newest first, MAX_TIME_HISTORY_POINTS slots per request
+            for (int64_t end = gap.second; end > gap.first; ) {
+                int64_t slots = std::min<int64_t>((end - gap.first) / SLOT, MAX_TIME_HISTORY_POINTS);
+                _queue.push_back(CStep { 0, end - SLOT, (uint8_t)slots, 0 });
+                end -= slots * SLOT;
+                ++planned;
+            }
+        }
+    }
+    return planned;
+}
+
+bool CBackfillJob::run(msec_t now)
+{
+    while (_in_flight < _window && !_queue.empty()) {
+        CStep step = _queue.front();
+        if (!send(step, now)) {
+            // out of budget or the port is gone, try again on the next run
+            break;
+        }
+        _queue.pop_front();
+        ++_in_flight;
+    }
+    return !done();
+}
+
+bool CBackfillJob::send(const CStep &step, msec_t now)
+{
+    uint8_t select_edt[7];
+    CEchonetProperty select;
+    CEchonetProperty reads[2];
+    size_t read_count;
+
+    if (_mode == BACKFILL_DAY_HISTORY) {
+        select_edt[0] = (uint8_t)step.day;
+        select = CEchonetProperty { EPC_HISTORY_DAY, 1, select_edt };
+        reads[0] = CEchonetProperty { EPC_HISTORY_NORMAL, 0, nullptr };
+        reads[1] = CEchonetProperty { EPC_HISTORY_REVERSE, 0, nullptr };
+        read_count = _reverse ? 2 : 1;
+    } else {
+        time_t tt = (time_t)step.time;
+        struct tm tm;
+        localtime_r(&tt, &tm);
+        int year = tm.tm_year + 1900;
+        select_edt[0] = (uint8_t)(year >> 8);
+        select_edt[1] = (uint8_t)year;
+        select_edt[2] = (uint8_t)(tm.tm_mon + 1);
+        select_edt[3] = (uint8_t)tm.tm_mday;
+        select_edt[4] = (uint8_t)tm.tm_hour;
+        select_edt[5] = (uint8_t)tm.tm_min;
+        select_edt[6] = step.count;
+        select = CEchonetProperty { EPC_HISTORY2_TIME, 7, select_edt };
+        reads[0] = CEchonetProperty { EPC_HISTORY2, 0, nullptr };
+        read_count = 1;
+    }
+
+    // the read echoes the selection, so the Set answer itself is not needed
+    if (!_requester.transact(_meter, EOJ_SMART_METER, ESV_SETC, &select, 1, nullptr, now)) {
+        return false;
+    }
+    return _requester.transact(_meter, EOJ_SMART_METER, ESV_GET, reads, read_count,
+                               [this, step](const CEchonetFrame *response) { on_response(step, response); }, now);
+}
+
+void CBackfillJob::on_response(const CStep &step, const CEchonetFrame *response)
+{
+    --_in_flight;
+    if (response == nullptr || response->esv != ESV_GET_RES) {
+        retry(step);
+        return;
+    }
+
+    bool ok = _mode == BACKFILL_DAY_HISTORY ? decode_day_history(step, *response) : decode_time_history(step, *response);
+    if (!ok) {
+        retry(step);
+        return;
+    }
+    insert();
+}
+
+bool CBackfillJob::decode_day_history(const CStep &step, const CEchonetFrame &response)
+{
+    const size_t size = 2 + DAY_POINTS * 4;
+    const CEchonetProperty *normal = find_property(response, EPC_HISTORY_NORMAL);
+    const CEchonetProperty *reverse = _reverse ? find_property(response, EPC_HISTORY_REVERSE) : nullptr;
+    if (normal == nullptr || normal->pdc != size || ((normal->edt[0] << 8) | normal->edt[1]) != step.day) {
+        return false;
+    }
+    if (reverse != nullptr && (reverse->pdc != size || ((reverse->edt[0] << 8) | reverse->edt[1]) != step.day)) {
+        reverse = nullptr;
+    }
+
+    const int64_t day_start = local_midnight(_today - (int64_t)step.day * DAY + DAY / 2);
+    _records.clear();
+    for (int i = 0; i < DAY_POINTS; ++i) {
+        CIntervalRecord record;
+        record.time = day_start + i * SLOT;
+        record.normal = be32(normal->edt + 2 + i * 4);
+        record.reverse = reverse != nullptr ? be32(reverse->edt + 2 + i * 4) : CIntervalRecord::NO_DATA;
+        if (record.normal != CIntervalRecord::NO_DATA || record.reverse != CIntervalRecord::NO_DATA) {
+            _records.push_back(record);
+        }
+    }
+    return true;
+}
+
+bool CBackfillJob::decode_time_history(const CStep &step, const CEchonetFrame &response)
+{
+    const CEchonetProperty *history = find_property(response, EPC_HISTORY2);
+    if (history == nullptr || history->pdc < 7) {
+        return false;
+    }
+    const uint8_t *edt = history->edt;
+    const uint8_t count = edt[6];
+    if (history->pdc != 7 + count * 8) {
+        return false;
+    }
+
+    struct tm tm = {};
+    tm.tm_year = ((edt[0] << 8) | edt[1]) - 1900;
+    tm.tm_mon = edt[2] - 1;
+    tm.tm_mday = edt[3];
+    tm.tm_hour = edt[4];
+    tm.tm_min = edt[5];
+    tm.tm_isdst = -1;
+    if ((int64_t)mktime(&tm) != step.time) {
+        return false;
+    }
+
+    // newest first, each point one slot before the previous
+    _records.clear();
+    for (int i = 0; i < count; ++i) {
+        CIntervalRecord record;
+        record.time = step.time - i * SLOT;
+        record.normal = be32(edt + 7 + i * 8);
+        record.reverse = be32(edt + 7 + i * 8 + 4);
+        if (record.normal != CIntervalRecord::NO_DATA || record.reverse != CIntervalRecord::NO_DATA) {
+            _records.push_back(record);
+        }
+    }
+    return true;
+}
+
+void CBackfillJob::retry(CStep step)
+{
+    if (++step.retries > MAX_RETRIES) {
+        ++_failed;
+        return;
+    }
+    _queue.push_back(step);
+}
+
+void CBackfillJob::insert()
+{
+    if (_records.empty()) {
+        return;
+    }
+    int ret = _store.insert_bulk(_records.data(), _records.size());
+    if (ret > 0) {
+        _inserted += ret;
+    }
+}
+
+int store_fixed_time_reading(CIntervalStore &store, uint8_t epc, const uint8_t *edt, uint8_t pdc)
+{
+    // YYYY MM DD hh mm ss, then the value
+    if ((epc != EPC_FIXED_TIME_NORMAL && epc != EPC_FIXED_TIME_REVERSE) || edt == nullptr || pdc != 11) {
+        return E_STORE_INVALID_ARG;
+    }
+
+    struct tm tm = {};
+    tm.tm_year = ((edt[0] << 8) | edt[1]) - 1900;
+    tm.tm_mon = edt[2] - 1;
+    tm.tm_mday = edt[3];
+    tm.tm_hour = edt[4];
+    tm.tm_min = edt[5];
+    tm.tm_sec = edt[6];
+    tm.tm_isdst = -1;
+    const int64_t time = (int64_t)mktime(&tm);
+    if (time <= 0 || time % SLOT != 0) {
+        return E_STORE_INVALID_ARG;
+    }
+
+    CIntervalRecord record { time, CIntervalRecord::NO_DATA, CIntervalRecord::NO_DATA };
+    const uint32_t value = be32(edt + 7);
+    if (epc == EPC_FIXED_TIME_NORMAL) {
+        record.normal = value;
+    } else {
+        record.reverse = value;
+    }
+    if (value == CIntervalRecord::NO_DATA) {
+        return 0;
+    }
+    return store.insert_bulk(&record, 1);
+}
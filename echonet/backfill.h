@@ -0,0 +1,99 @@
+#ifndef _ECHONET_BACKFILL_H_
+#define _ECHONET_BACKFILL_H_
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "requester.h"
+#include "../storage/interval_store.h"
+
+enum CBackfillMode {
+    BACKFILL_DAY_HISTORY,       // 0xE5 selects a day, 0xE2/0xE4 return its 48 points
+    BACKFILL_TIME_HISTORY,      // 0xED selects a time, 0xEC returns up to 12 points before it
+};
+
+/*
+  fills the gaps of the interval store from the meter's own history.
+
+  every gap is turned into (select, read) request pairs which are sent
+  back to back, up to window pairs at once. the read response echoes the
+  selected day or time, so a pair which was answered for the wrong
+  selection is detected and sent again. each response is decoded in one
+  pass and inserted into the store as one batch.
+ */
+class CBackfillJob
+{
+public:
+    using msec_t = CEchonetRequester::msec_t;
+
+    static constexpr int MAX_HISTORY_DAYS = 99;
+    static constexpr int MAX_TIME_HISTORY_POINTS = 12;
+    static constexpr int MAX_RETRIES = 3;
+
+    CBackfillJob(CEchonetRequester &requester, CIntervalStore &store, const node_addr_t &meter,
+                 CBackfillMode mode = BACKFILL_DAY_HISTORY, bool reverse = true, size_t window = 2)
+        : _requester(requester), _store(store), _meter(meter), _mode(mode), _reverse(reverse),
+          _window(window), _in_flight(0), _inserted(0), _failed(0), _today(0)
+    {
+    }
+
+    // queues the requests covering the gaps in [from, to), epoch seconds
+    size_t plan(int64_t from, int64_t to, int64_t now);
+
+    // keeps the pipeline full. returns false once everything is done
+    bool run(msec_t now);
+
+    bool done() const
+    {
+        return _queue.empty() && _in_flight == 0;
+    }
+
+    size_t inserted() const
+    {
+        return _inserted;
+    }
+
+    size_t failed() const
+    {
+        return _failed;
+    }
+
+private:
+    struct CStep
+    {
+        int day;            // BACKFILL_DAY_HISTORY: days before today
+        int64_t time;       // BACKFILL_TIME_HISTORY: newest slot wanted
+        uint8_t count;      // BACKFILL_TIME_HISTORY: number of slots
+        int retries;
+    };
+
+    CEchonetRequester &_requester;
+    CIntervalStore &_store;
+    node_addr_t _meter;
+    CBackfillMode _mode;
+    bool _reverse;
+    size_t _window;
+
+    std::deque<CStep> _queue;
+    size_t _in_flight;
+    size_t _inserted;
+    size_t _failed;
+
+    int64_t _today;     // local midnight when planned
+    std::vector<CIntervalRecord> _records;
+
+    bool send(const CStep &step, msec_t now);
+    void on_response(const CStep &step, const CEchonetFrame *response);
+    bool decode_day_history(const CStep &step, const CEchonetFrame &response);
+    bool decode_time_history(const CStep &step, const CEchonetFrame &response);
+    void retry(CStep step);
+    void insert();
+};
+
+// stores a polled 0xEA/0xEB (cumulative energy at the last 30 minute
+// boundary) as its slot, so the next plan() does not ask for it again.
+// returns the number of slots changed or a CStoreError
+int store_fixed_time_reading(CIntervalStore &store, uint8_t epc, const uint8_t *edt, uint8_t pdc);
+
+#endif
@@ -0,0 +1,94 @@
+#include <algorithm>
+
+#include "discovery.h"
+
+namespace {
+
+const CEchonetProperty MAP_GETS[] = {
+    { EPC_GET_MAP, 0, nullptr },
+    { EPC_SET_MAP, 0, nullptr },
+    { EPC_ANNOUNCE_MAP, 0, nullptr },
+};
+
+const CEchonetProperty INSTANCE_LIST_GET[] = {
+    { EPC_INSTANCE_LIST, 0, nullptr },
+};
+
+}
+
+bool CNodeDiscovery::start()
+{
+    return _requester.send(ECHONET_MULTICAST, EOJ_NODE_PROFILE, ESV_GET, INSTANCE_LIST_GET, 1);
+}
+
+void CNodeDiscovery::observe(const node_addr_t &sender, const CEchonetFrame &frame, msec_t now)
+{
+    const uint8_t esv = frame.esv;
+    if (esv != ESV_GET_RES && esv != ESV_GET_SNA && esv != ESV_INF && esv != ESV_INFC) {
+        return;
+    }
+
+    for (const auto &prop : frame.properties) {
+        if (prop.pdc == 0) {
+            continue;
+        }
+        switch (prop.epc) {
+        case EPC_INSTANCE_LIST_NOTIFY:
+        case EPC_INSTANCE_LIST:
+            if (frame.seoj.group == EOJ_NODE_PROFILE.group && frame.seoj.cls == EOJ_NODE_PROFILE.cls) {
+                _index.add_instances(sender, prop.edt, prop.pdc);
+                for (const auto &entry : _index.objects()) {
+                    if (entry.node == sender && !entry.has_map(MAP_GET)) {
+                        enqueue(sender, entry.eoj);
+                    }
+                }
+            }
+            break;
+        case EPC_ANNOUNCE_MAP:
+        case EPC_SET_MAP:
+        case EPC_GET_MAP:
+            _index.set_map(sender, frame.seoj, prop.epc, prop.edt, prop.pdc);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void CNodeDiscovery::enqueue(const node_addr_t &node, const CEoj &eoj)
+{
+    auto it = std::find_if(_queue.begin(), _queue.end(), [&](const CFetch &fetch) {
+        return fetch.eoj == eoj && fetch.node == node;
+    });
+    if (it == _queue.end()) {
+        _queue.push_back(CFetch { node, eoj, 0 });
+    }
+}
+
+bool CNodeDiscovery::run(msec_t now)
+{
+    while (_in_flight < _window && !_queue.empty()) {
+        CFetch fetch = _queue.front();
+        const CNodeIndex::CObjectEntry *entry = _index.find(fetch.node, fetch.eoj);
+        if (entry != nullptr && entry->has_map(MAP_GET)) {
+            // announced meanwhile
+            _queue.pop_front();
+            continue;
+        }
+
+        bool sent = _requester.transact(fetch.node, fetch.eoj, ESV_GET, MAP_GETS, 3, [this, fetch](const CEchonetFrame *response) {
+            --_in_flight;
+            // a response was already stored by observe()
+            if (response == nullptr && fetch.retries + 1 < MAX_RETRIES) {
+                _queue.push_back(CFetch { fetch.node, fetch.eoj, fetch.retries + 1 });
+            }
+        }, now);
+        if (!sent) {
+            // out of transmit budget, try again on the next run
+            break;
+        }
+        _queue.pop_front();
+        ++_in_flight;
+    }
+    return !done();
+}
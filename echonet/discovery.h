@@ -0,0 +1,60 @@
+#ifndef _ECHONET_DISCOVERY_H_
+#define _ECHONET_DISCOVERY_H_
+
+#include <deque>
+
+#include "node_index.h"
+#include "requester.h"
+
+/*
+  fills the node index.
+
+  start() multicasts a Get of the node profile's instance list (0xD6).
+  every instance list seen afterwards, answered or announced (0xD5),
+  registers the node's objects, and each object whose Get property map
+  is unknown gets one Get for 0x9F, 0x9E and 0x9D. at most window such
+  Gets are in flight so discovery does not crowd out the polls.
+ */
+class CNodeDiscovery
+{
+public:
+    using msec_t = CEchonetRequester::msec_t;
+
+    static constexpr int MAX_RETRIES = 3;
+
+    CNodeDiscovery(CEchonetRequester &requester, CNodeIndex &index, size_t window = 1)
+        : _requester(requester), _index(index), _window(window), _in_flight(0)
+    {
+    }
+
+    bool start();
+
+    // hand every frame to this, see CEchonetRequester::set_frame_observer
+    void observe(const node_addr_t &sender, const CEchonetFrame &frame, msec_t now);
+
+    // sends the queued property map Gets. returns false when idle
+    bool run(msec_t now);
+
+    bool done() const
+    {
+        return _queue.empty() && _in_flight == 0;
+    }
+
+private:
+    struct CFetch
+    {
+        node_addr_t node;
+        CEoj eoj;
+        int retries;
+    };
+
+    CEchonetRequester &_requester;
+    CNodeIndex &_index;
+    size_t _window;
+    size_t _in_flight;
+    std::deque<CFetch> _queue;
+
+    void enqueue(const node_addr_t &node, const CEoj &eoj);
+};
+
+#endif
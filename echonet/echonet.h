@@ -0,0 +1,97 @@
+#ifndef _ECHONET_ECHONET_H_
+#define _ECHONET_ECHONET_H_
+
+#include <cstdint>
+
+#include "../event/schema.h"
+
+using node_addr_t = sk_ipv6::value_type;
+
+constexpr uint16_t ECHONET_PORT = 0x0E1A;   // 3610
+
+constexpr uint8_t EHD1_ECHONET_LITE = 0x10;
+constexpr uint8_t EHD2_FORMAT1      = 0x81;
+
+// ESV
+enum {
+    ESV_SETI_SNA      = 0x50,
+    ESV_SETC_SNA      = 0x51,
+    ESV_GET_SNA       = 0x52,
+    ESV_INF_SNA       = 0x53,
+    ESV_SETGET_SNA    = 0x5E,
+    ESV_SETI          = 0x60,
+    ESV_SETC          = 0x61,
+    ESV_GET           = 0x62,
+    ESV_INF_REQ       = 0x63,
+    ESV_SETGET        = 0x6E,
+    ESV_SET_RES       = 0x71,
+    ESV_GET_RES       = 0x72,
+    ESV_INF           = 0x73,
+    ESV_INFC          = 0x74,
+    ESV_INFC_RES      = 0x7A,
+    ESV_SETGET_RES    = 0x7E,
+};
+
+// every object (device object super class, node profile)
+enum {
+    EPC_ANNOUNCE_MAP            = 0x9D,     // status change announcement property map
+    EPC_SET_MAP                 = 0x9E,
+    EPC_GET_MAP                 = 0x9F,
+    EPC_INSTANCE_LIST_NOTIFY    = 0xD5,     // node profile only
+    EPC_INSTANCE_LIST           = 0xD6,     // node profile only
+};
+
+// low voltage smart electric energy meter (0x0288)
+enum {
+    EPC_OPERATION_STATUS        = 0x80,
+    EPC_COEFFICIENT             = 0xD3,
+    EPC_EFFECTIVE_DIGITS        = 0xD7,
+    EPC_CUMULATIVE_NORMAL       = 0xE0,
+    EPC_CUMULATIVE_UNIT         = 0xE1,
+    EPC_HISTORY_NORMAL          = 0xE2,
+    EPC_CUMULATIVE_REVERSE      = 0xE3,
+    EPC_HISTORY_REVERSE         = 0xE4,
+    EPC_HISTORY_DAY             = 0xE5,
+    EPC_INSTANT_POWER           = 0xE7,
+    EPC_INSTANT_CURRENT         = 0xE8,
+    EPC_FIXED_TIME_NORMAL       = 0xEA,
+    EPC_FIXED_TIME_REVERSE      = 0xEB,
+    EPC_HISTORY2                = 0xEC,
+    EPC_HISTORY2_TIME           = 0xED,
+};
+
+struct CEoj
+{
+    uint8_t group;
+    uint8_t cls;
+    uint8_t instance;
+
+    constexpr uint32_t code() const
+    {
+        return ((uint32_t)group << 16) | ((uint32_t)cls << 8) | instance;
+    }
+
+    static constexpr CEoj from_code(uint32_t code)
+    {
+        return CEoj { (uint8_t)(code >> 16), (uint8_t)(code >> 8), (uint8_t)code };
+    }
+
+    constexpr bool operator==(const CEoj &other) const
+    {
+        return code() == other.code();
+    }
+
+    constexpr bool operator!=(const CEoj &other) const
+    {
+        return code() != other.code();
+    }
+};
+
+constexpr CEoj EOJ_CONTROLLER   = { 0x05, 0xFF, 0x01 };
+constexpr CEoj EOJ_SMART_METER  = { 0x02, 0x88, 0x01 };
+constexpr CEoj EOJ_NODE_PROFILE = { 0x0E, 0xF0, 0x01 };
+
+// all nodes on the link, FF02::1
+constexpr node_addr_t ECHONET_MULTICAST = { 0xFF, 0x02, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x01 };
+
+#endif
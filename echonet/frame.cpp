@@ -0,0 +1,101 @@
+#include "frame.h"
+
+namespace {
+
+bool has_two_lists(uint8_t esv)
+{
+    return esv == ESV_SETGET || esv == ESV_SETGET_RES || esv == ESV_SETGET_SNA;
+}
+
+bool decode_properties(const uint8_t *&p, const uint8_t *end, std::vector<CEchonetProperty> &out)
+{
+    if (p >= end) {
+        return false;
+    }
+    uint8_t opc = *p++;
+    for (uint8_t i = 0; i < opc; ++i) {
+        if (end - p < 2) {
+            return false;
+        }
+        CEchonetProperty prop;
+        prop.epc = p[0];
+        prop.pdc = p[1];
+        p += 2;
+        if (end - p < prop.pdc) {
+            return false;
+        }
+        prop.edt = p;
+        p += prop.pdc;
+        out.push_back(prop);
+    }
+    return true;
+}
+
+void encode_properties(std::vector<uint8_t> &out, const CEchonetProperty *props, size_t count)
+{
+    out.push_back((uint8_t)count);
+    for (size_t i = 0; i < count; ++i) {
+        out.push_back(props[i].epc);
+        out.push_back(props[i].pdc);
+        if (props[i].pdc > 0) {
+            out.insert(out.end(), props[i].edt, props[i].edt + props[i].pdc);
+        }
+    }
+}
+
+} // namespace
+
+bool CEchonetFrame::decode(const uint8_t *data, size_t length)
+{
+    properties.clear();
+    set_count = 0;
+    if (data == nullptr || length < 12 || data[0] != EHD1_ECHONET_LITE || data[1] != EHD2_FORMAT1) {
+        return false;
+    }
+
+    tid = (uint16_t)((data[2] << 8) | data[3]);
+    seoj = CEoj { data[4], data[5], data[6] };
+    deoj = CEoj { data[7], data[8], data[9] };
+    esv = data[10];
+
+    const uint8_t *p = data + 11;
+    const uint8_t *end = data + length;
+    if (!decode_properties(p, end, properties)) {
+        return false;
+    }
+    if (has_two_lists(esv)) {
+        set_count = (uint8_t)properties.size();
+        if (!decode_properties(p, end, properties)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CEchonetFrame::encode(std::vector<uint8_t> &out, uint16_t tid, const CEoj &seoj, const CEoj &deoj, uint8_t esv,
+                           const CEchonetProperty *props, size_t count)
+{
+    out.clear();
+    const uint8_t header[] = {
+        EHD1_ECHONET_LITE, EHD2_FORMAT1,
+        (uint8_t)(tid >> 8), (uint8_t)tid,
+        seoj.group, seoj.cls, seoj.instance,
+        deoj.group, deoj.cls, deoj.instance,
+        esv,
+    };
+    out.insert(out.end(), header, header + sizeof(header));
+    encode_properties(out, props, count);
+}
+
+void CEchonetFrame::encode_get(std::vector<uint8_t> &out, uint16_t tid, const CEoj &seoj, const CEoj &deoj,
+                               const uint8_t *epcs, size_t count)
+{
+    CEchonetProperty props[255];
+    if (count > 255) {
+        count = 255;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        props[i] = CEchonetProperty { epcs[i], 0, nullptr };
+    }
+    encode(out, tid, seoj, deoj, ESV_GET, props, count);
+}
@@ -0,0 +1,54 @@
+#ifndef _ECHONET_FRAME_H_
+#define _ECHONET_FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "echonet.h"
+
+// EDT points into the buffer the frame was decoded from
+struct CEchonetProperty
+{
+    uint8_t epc;
+    uint8_t pdc;
+    const uint8_t *edt;
+};
+
+/*
+  ECHONET Lite format 1 frame:
+      EHD1 EHD2 TID(2) SEOJ(3) DEOJ(3) ESV OPC {EPC PDC EDT}...
+  SetGet frames carry two property lists (OPCSet, OPCGet); the Set part
+  comes first in properties and set_count tells where it ends.
+ */
+class CEchonetFrame
+{
+public:
+    uint16_t tid;
+    CEoj seoj;
+    CEoj deoj;
+    uint8_t esv;
+    uint8_t set_count;
+    std::vector<CEchonetProperty> properties;
+
+    bool decode(const uint8_t *data, size_t length);
+
+    bool decode(const std::vector<uint8_t> &data)
+    {
+        return decode(data.data(), data.size());
+    }
+
+    static void encode(std::vector<uint8_t> &out, uint16_t tid, const CEoj &seoj, const CEoj &deoj, uint8_t esv,
+                       const CEchonetProperty *props, size_t count);
+
+    // Get with an empty EDT for every EPC
+    static void encode_get(std::vector<uint8_t> &out, uint16_t tid, const CEoj &seoj, const CEoj &deoj,
+                           const uint8_t *epcs, size_t count);
+
+    static bool is_response(uint8_t esv)
+    {
+        return (0x70 <= esv && esv <= 0x7F) || (0x50 <= esv && esv <= 0x5F);
+    }
+};
+
+#endif
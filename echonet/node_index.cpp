@@ -0,0 +1,112 @@
+#include "node_index.h"
+
+bool CEpcSet::decode(const uint8_t *edt, uint8_t pdc)
+{
+    clear();
+    if (pdc < 1) {
+        return false;
+    }
+    const uint8_t count = edt[0];
+    if (count < 16) {
+        if (pdc < 1 + count) {
+            return false;
+        }
+        for (int i = 0; i < count; ++i) {
+            set(edt[1 + i]);
+        }
+        return true;
+    }
+
+    if (pdc < 17) {
+        return false;
+    }
+    for (int i = 0; i < 16; ++i) {
+        for (int b = 0; b < 8; ++b) {
+            if (edt[1 + i] & (1 << b)) {
+                set((uint8_t)(0x80 + b * 16 + i));
+            }
+        }
+    }
+    return true;
+}
+
+CNodeIndex::CObjectEntry &CNodeIndex::add(const node_addr_t &node, const CEoj &eoj)
+{
+    auto result = _slots.emplace(CPropertyKey { node, eoj.code(), 0 }, (uint32_t)_objects.size());
+    if (result.second) {
+        CObjectEntry entry {};
+        entry.node = node;
+        entry.eoj = eoj;
+        _objects.push_back(entry);
+    }
+    return _objects[result.first->second];
+}
+
+int CNodeIndex::add_instances(const node_addr_t &node, const uint8_t *edt, uint8_t pdc)
+{
+    if (pdc < 1 || pdc < 1 + edt[0] * 3) {
+        return 0;
+    }
+
+    const size_t before = _objects.size();
+    add(node, EOJ_NODE_PROFILE);
+    for (int i = 0; i < edt[0]; ++i) {
+        const uint8_t *p = edt + 1 + i * 3;
+        add(node, CEoj { p[0], p[1], p[2] });
+    }
+    return (int)(_objects.size() - before);
+}
+
+bool CNodeIndex::set_map(const node_addr_t &node, const CEoj &eoj, uint8_t epc, const uint8_t *edt, uint8_t pdc)
+{
+    CPropertyMapType type;
+    switch (epc) {
+    case EPC_ANNOUNCE_MAP:
+        type = MAP_ANNOUNCE;
+        break;
+    case EPC_SET_MAP:
+        type = MAP_SET;
+        break;
+    case EPC_GET_MAP:
+        type = MAP_GET;
+        break;
+    default:
+        return false;
+    }
+
+    CEpcSet map;
+    if (!map.decode(edt, pdc)) {
+        return false;
+    }
+    CObjectEntry &entry = add(node, eoj);
+    entry.maps[type] = map;
+    entry.known |= 1 << type;
+    return true;
+}
+
+const CNodeIndex::CObjectEntry *CNodeIndex::find_object(const CEoj &eoj) const
+{
+    for (const auto &entry : _objects) {
+        if (entry.eoj == eoj) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+void CNodeIndex::remove_node(const node_addr_t &node)
+{
+    std::vector<CObjectEntry> objects;
+    objects.reserve(_objects.size());
+    for (const auto &entry : _objects) {
+        if (entry.node != node) {
+            objects.push_back(entry);
+        }
+    }
+    _objects.swap(objects);
+
+    _slots.clear();
+    for (uint32_t i = 0; i < _objects.size(); ++i) {
+        _slots.emplace(CPropertyKey { _objects[i].node, _objects[i].eoj.code(), 0 }, i);
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef _ECHONET_NODE_INDEX_H_
+#define _ECHONET_NODE_INDEX_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "echonet.h"
+#include "property_cache.h"
+
+// EPCs 0x80-0xFF as a 128 bit set
+struct CEpcSet
+{
+    uint64_t words[2];
+
+    void clear()
+    {
+        words[0] = words[1] = 0;
+    }
+
+    void set(uint8_t epc)
+    {
+        if (epc & 0x80) {
+            words[(epc >> 6) & 1] |= 1ULL << (epc & 0x3F);
+        }
+    }
+
+    bool test(uint8_t epc) const
+    {
+        return (epc & 0x80) && (words[(epc >> 6) & 1] >> (epc & 0x3F)) & 1;
+    }
+
+    int count() const
+    {
+        return __builtin_popcountll(words[0]) + __builtin_popcountll(words[1]);
+    }
+
+    /*
+      property map EDT: the number of properties, then
+      - fewer than 16: the EPCs themselves
+      - 16 or more: 16 bytes, bit b of byte i stands for EPC 0x80 + b * 16 + i
+     */
+    bool decode(const uint8_t *edt, uint8_t pdc);
+};
+
+enum CPropertyMapType {
+    MAP_ANNOUNCE,       // 0x9D
+    MAP_SET,            // 0x9E
+    MAP_GET,            // 0x9F
+    MAP_COUNT,
+};
+
+/*
+  what each node on the network hosts: node -> EOJ -> supported EPCs.
+
+  objects live in one vector and (node, EOJ) maps to their slot, so the
+  lookups behind every request are one hash probe and one bit test.
+ */
+class CNodeIndex
+{
+public:
+    struct CObjectEntry
+    {
+        node_addr_t node;
+        CEoj eoj;
+        uint8_t known;                  // bit per CPropertyMapType
+        CEpcSet maps[MAP_COUNT];
+
+        bool has_map(CPropertyMapType type) const
+        {
+            return known & (1 << type);
+        }
+    };
+
+    // registers the object if it is new
+    CObjectEntry &add(const node_addr_t &node, const CEoj &eoj);
+
+    // instance list (0xD5 / 0xD6 EDT) of a node. returns the number of new objects
+    int add_instances(const node_addr_t &node, const uint8_t *edt, uint8_t pdc);
+
+    // 0x9D / 0x9E / 0x9F EDT of an object
+    bool set_map(const node_addr_t &node, const CEoj &eoj, uint8_t epc, const uint8_t *edt, uint8_t pdc);
+
+    const CObjectEntry *find(const node_addr_t &node, const CEoj &eoj) const
+    {
+        auto it = _slots.find(CPropertyKey { node, eoj.code(), 0 });
+        return it == _slots.end() ? nullptr : &_objects[it->second];
+    }
+
+    // false only when the object's map is known and lacks the EPC
+    bool may_support(const node_addr_t &node, const CEoj &eoj, CPropertyMapType type, uint8_t epc) const
+    {
+        const CObjectEntry *entry = find(node, eoj);
+        return entry == nullptr || !entry->has_map(type) || entry->maps[type].test(epc);
+    }
+
+    // first node hosting an object of eoj's class and instance
+    const CObjectEntry *find_object(const CEoj &eoj) const;
+
+    const std::vector<CObjectEntry> &objects() const
+    {
+        return _objects;
+    }
+
+    void remove_node(const node_addr_t &node);
+
+private:
+    std::vector<CObjectEntry> _objects;
+    std::unordered_map<CPropertyKey, uint32_t, CPropertyKeyHash> _slots;
+};
+
+#endif
@@ -0,0 +1,54 @@
+#include "property_cache.h"
+
+namespace {
+const CPropertyCache::msec_t DEFAULT_TTL = 10 * 1000;
+const CPropertyCache::msec_t STATIC_TTL = 24 * 60 * 60 * 1000;
+}
+
+CPropertyCache::CPropertyCache()
+{
+    _ttl.fill(DEFAULT_TTL);
+
+    // meter configuration
+    _ttl[EPC_COEFFICIENT] = STATIC_TTL;
+    _ttl[EPC_EFFECTIVE_DIGITS] = STATIC_TTL;
+    _ttl[EPC_CUMULATIVE_UNIT] = STATIC_TTL;
+
+    // instantaneous values
+    _ttl[EPC_INSTANT_POWER] = 5 * 1000;
+    _ttl[EPC_INSTANT_CURRENT] = 5 * 1000;
+
+    // cumulative values are updated by the meter every 30 minutes at best
+    _ttl[EPC_CUMULATIVE_NORMAL] = 60 * 1000;
+    _ttl[EPC_CUMULATIVE_REVERSE] = 60 * 1000;
+    _ttl[EPC_FIXED_TIME_NORMAL] = 5 * 60 * 1000;
+    _ttl[EPC_FIXED_TIME_REVERSE] = 5 * 60 * 1000;
+
+    // history depends on the day selected by a Set, never serve it from
+    // cache. nor the selection itself, it is what the last Set wrote
+    _ttl[EPC_HISTORY_NORMAL] = 0;
+    _ttl[EPC_HISTORY_REVERSE] = 0;
+    _ttl[EPC_HISTORY_DAY] = 0;
+    _ttl[EPC_HISTORY2] = 0;
+    _ttl[EPC_HISTORY2_TIME] = 0;
+}
+
+const CPropertyCache::CEntry &CPropertyCache::store(const CPropertyKey &key, const uint8_t *edt, uint8_t pdc, msec_t now)
+{
+    CEntry &entry = _entries[key];
+    entry.stored_at = now;
+    entry.expires_at = now + _ttl[key.epc];
+    entry.edt.assign(edt, edt + pdc);
+    return entry;
+}
+
+void CPropertyCache::purge(msec_t now)
+{
+    for (auto it = _entries.begin(); it != _entries.end(); ) {
+        if (it->second.expires_at <= now) {
+            it = _entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
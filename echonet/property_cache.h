@@ -0,0 +1,97 @@
+#ifndef _ECHONET_PROPERTY_CACHE_H_
+#define _ECHONET_PROPERTY_CACHE_H_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "echonet.h"
+
+struct CPropertyKey
+{
+    node_addr_t node;
+    uint32_t eoj;
+    uint8_t epc;
+
+    bool operator==(const CPropertyKey &other) const
+    {
+        return eoj == other.eoj && epc == other.epc && node == other.node;
+    }
+};
+
+struct CPropertyKeyHash
+{
+    size_t operator()(const CPropertyKey &key) const
+    {
+        uint64_t hi, lo;
+        std::memcpy(&hi, key.node.data(), sizeof(hi));
+        std::memcpy(&lo, key.node.data() + 8, sizeof(lo));
+        uint64_t h = hi * 0x9E3779B97F4A7C15ULL;
+        h ^= lo + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+        h ^= (((uint64_t)key.eoj << 8) | key.epc) * 0xC2B2AE3D27D4EB4FULL;
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+/*
+  last known EDT of each (node, EOJ, EPC).
+  how long a value stays fresh depends on the EPC: instantaneous values
+  age in seconds, coefficients and units practically never change.
+ */
+class CPropertyCache
+{
+public:
+    using msec_t = long long;
+
+    struct CEntry
+    {
+        msec_t stored_at;
+        msec_t expires_at;
+        std::vector<uint8_t> edt;
+    };
+
+    CPropertyCache();
+
+    // nullptr when the value is unknown or older than its TTL
+    const CEntry *find(const CPropertyKey &key, msec_t now) const
+    {
+        auto it = _entries.find(key);
+        if (it == _entries.end() || it->second.expires_at <= now) {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    const CEntry &store(const CPropertyKey &key, const uint8_t *edt, uint8_t pdc, msec_t now);
+
+    void invalidate(const CPropertyKey &key)
+    {
+        _entries.erase(key);
+    }
+
+    // drops stale entries
+    void purge(msec_t now);
+
+    void set_ttl(uint8_t epc, msec_t ttl_msec)
+    {
+        _ttl[epc] = ttl_msec;
+    }
+
+    msec_t get_ttl(uint8_t epc) const
+    {
+        return _ttl[epc];
+    }
+
+    size_t size() const
+    {
+        return _entries.size();
+    }
+
+private:
+    std::unordered_map<CPropertyKey, CEntry, CPropertyKeyHash> _entries;
+    std::array<msec_t, 256> _ttl;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#include "reading.h"
+
+namespace {
+
+int64_t be_unsigned(const std::vector<uint8_t> &edt)
+{
+    uint64_t v = 0;
+    for (uint8_t c : edt) {
+        v = (v << 8) | c;
+    }
+    return (int64_t)v;
+}
+
+}
+
+void CReading::decode()
+{
+    value.reset();
+    switch (epc) {
+    case EPC_INSTANT_POWER:
+        if (edt.size() == 4) {
+            value = (int32_t)be_unsigned(edt);
+        }
+        break;
+    case EPC_CUMULATIVE_NORMAL:
+    case EPC_CUMULATIVE_REVERSE:
+    case EPC_COEFFICIENT:
+        if (edt.size() == 4) {
+            value = be_unsigned(edt);
+        }
+        break;
+    case EPC_CUMULATIVE_UNIT:
+    case EPC_EFFECTIVE_DIGITS:
+        if (edt.size() == 1) {
+            value = edt[0];
+        }
+        break;
+    default:
+        break;
+    }
+}
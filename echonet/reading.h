@@ -0,0 +1,63 @@
+#ifndef _ECHONET_READING_H_
+#define _ECHONET_READING_H_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "echonet.h"
+#include "../serialize/formats.h"
+
+/*
+  one property value as received from a node, with the number it stands
+  for when the EPC is a known meter value. serialized with the same
+  formats as the events, under the kind READING_KIND.
+ */
+struct CReading
+{
+    static constexpr uint8_t READING_KIND = 0x80;
+
+    long long time;         // msec since the epoch
+    node_addr_t node;
+    CEoj eoj;
+    uint8_t epc;
+    std::vector<uint8_t> edt;
+    std::optional<int64_t> value;
+
+    // fills value from edt for the meter EPCs which hold a single number
+    void decode();
+
+    bool serialize(COutputBuffer &out, CSerialFormat format) const
+    {
+        switch (format) {
+        case FORMAT_JSON:
+            return write<CJsonFormat>(out);
+        case FORMAT_CSV:
+            return write<CCsvFormat>(out);
+        case FORMAT_BINARY:
+            return write<CBinaryFormat>(out);
+        }
+        return false;
+    }
+
+    template <class Format>
+    bool write(COutputBuffer &out) const
+    {
+        size_t mark = Format::begin(out, READING_KIND, "READING");
+        Format::field(out, "TIME");
+        Format::value(out, (int64_t)time);
+        Format::field(out, "NODE");
+        Format::value(out, node);
+        Format::field(out, "EOJ");
+        Format::value(out, eoj.code());
+        Format::field(out, "EPC");
+        Format::value(out, epc);
+        Format::field(out, "EDT");
+        Format::value(out, edt);
+        Format::field(out, "VALUE");
+        Format::value(out, value);
+        return Format::end(out, mark);
+    }
+};
+
+#endif
@@ -0,0 +1,310 @@
+#include <algorithm>
+
+#include "requester.h"
+
+void CEchonetRequester::get(const node_addr_t &node, const CEoj &eoj, uint8_t epc, callback_type callback, msec_t now)
+{
+    CPropertyKey key { node, eoj.code(), epc };
+
+    const auto *entry = _cache.find(key, now);
+    if (entry != nullptr) {
+        callback(REQ_OK, entry->edt.data(), (uint8_t)entry->edt.size());
+        return;
+    }
+
+    if (_index != nullptr && !_index->may_support(node, eoj, MAP_GET, epc)) {
+        // would only come back as Get_SNA
+        ++_rejected;
+        callback(REQ_NOT_AVAILABLE, nullptr, 0);
+        return;
+    }
+
+    auto it = _waiting.find(key);
+    if (it != _waiting.end()) {
+        // queued or in flight, ride along
+        it->second.callbacks.push_back(std::move(callback));
+        return;
+    }
+
+    CWaitList &list = _waiting[key];
+    list.callbacks.push_back(std::move(callback));
+    list.sent = false;
+    _queued.push_back(key);
+}
+
+uint16_t CEchonetRequester::allocate_tid()
+{
+    uint16_t tid;
+    do {
+        tid = _next_tid++;
+    } while (tid == 0 || _transactions.count(tid) != 0);
+    return tid;
+}
+
+int CEchonetRequester::flush(msec_t now)
+{
+    if (_suspended) {
+        return 0;
+    }
+
+    int sent = 0;
+    while (!_parked.empty()) {
+        auto it = _transactions.find(_parked.front());
+        if (it != _transactions.end()) {
+            CSendResult result = _sender(it->second.node, it->second.frame);
+            if (result == SEND_DEFERRED) {
+                // keep the order, the rest waits for the next flush
+                return sent;
+            }
+            if (result == SEND_FAILED) {
+                CTransaction transaction = std::move(it->second);
+                _transactions.erase(it);
+                _parked.erase(_parked.begin());
+                transaction.on_response(nullptr);
+                continue;
+            }
+            it->second.parked = false;
+            it->second.deadline = now + _timeout;
+            note_sent(now);
+            ++sent;
+        }
+        _parked.erase(_parked.begin());
+    }
+
+    if (_queued.empty()) {
+        return sent;
+    }
+
+    std::vector<CPropertyKey> queued;
+    queued.swap(_queued);
+    std::stable_sort(queued.begin(), queued.end(), [](const CPropertyKey &a, const CPropertyKey &b) {
+        return a.node != b.node ? a.node < b.node : a.eoj < b.eoj;
+    });
+
+    for (size_t begin = 0; begin < queued.size(); ) {
+        size_t end = begin + 1;
+        while (end < queued.size() && end - begin < MAX_EPC_PER_GET
+               && queued[end].node == queued[begin].node && queued[end].eoj == queued[begin].eoj) {
+            ++end;
+        }
+
+        CTransaction transaction;
+        transaction.node = queued[begin].node;
+        transaction.eoj = CEoj::from_code(queued[begin].eoj);
+        transaction.deadline = now + _timeout;
+        transaction.parked = false;
+        for (size_t i = begin; i < end; ++i) {
+            transaction.epcs.push_back(queued[i].epc);
+        }
+
+        uint16_t tid = allocate_tid();
+        CEchonetFrame::encode_get(_frame, tid, _local_eoj, transaction.eoj, transaction.epcs.data(), transaction.epcs.size());
+        CSendResult result = _sender(transaction.node, _frame);
+        if (result == SEND_OK) {
+            for (size_t i = begin; i < end; ++i) {
+                _waiting[queued[i]].sent = true;
+            }
+            _transactions.emplace(tid, std::move(transaction));
+            note_sent(now);
+            ++sent;
+        } else if (result == SEND_DEFERRED) {
+            // this Get and everything after it waits for the next flush,
+            // ahead of whatever is queued meanwhile
+            _queued.insert(_queued.begin(), queued.begin() + begin, queued.end());
+            break;
+        } else {
+            for (size_t i = begin; i < end; ++i) {
+                complete(queued[i], REQ_SEND_FAILED, nullptr, 0);
+            }
+        }
+        begin = end;
+    }
+    return sent;
+}
+
+bool CEchonetRequester::transact(const node_addr_t &node, const CEoj &deoj, uint8_t esv, const CEchonetProperty *props, size_t count,
+                                 frame_callback_type callback, msec_t now)
+{
+    if (_suspended) {
+        return false;
+    }
+    uint16_t tid = allocate_tid();
+    CEchonetFrame::encode(_frame, tid, _local_eoj, deoj, esv, props, count);
+    if (_sender(node, _frame) != SEND_OK) {
+        return false;
+    }
+
+    CTransaction transaction;
+    transaction.node = node;
+    transaction.eoj = deoj;
+    transaction.deadline = now + _timeout;
+    transaction.on_response = std::move(callback);
+    transaction.frame = _frame;
+    transaction.parked = false;
+    _transactions.emplace(tid, std::move(transaction));
+    note_sent(now);
+    return true;
+}
+
+bool CEchonetRequester::send(const node_addr_t &node, const CEoj &deoj, uint8_t esv, const CEchonetProperty *props, size_t count)
+{
+    if (_suspended) {
+        return false;
+    }
+    CEchonetFrame::encode(_frame, allocate_tid(), _local_eoj, deoj, esv, props, count);
+    return _sender(node, _frame) == SEND_OK;
+}
+
+bool CEchonetRequester::handle(const node_addr_t &sender, const std::vector<uint8_t> &data, msec_t now)
+{
+    if (!_response.decode(data)) {
+        return false;
+    }
+
+    if (_observer) {
+        _observer(sender, _response, now);
+    }
+
+    const uint8_t esv = _response.esv;
+    if (esv == ESV_INF || esv == ESV_INFC) {
+        // announcements keep the cache warm as well
+        for (const auto &prop : _response.properties) {
+            if (prop.pdc > 0) {
+                CPropertyKey key { sender, _response.seoj.code(), prop.epc };
+                const auto &entry = _cache.store(key, prop.edt, prop.pdc, now);
+                complete(key, REQ_OK, entry.edt.data(), prop.pdc);
+            }
+        }
+        return false;
+    }
+    if (!CEchonetFrame::is_response(esv)) {
+        return false;
+    }
+
+    auto it = _transactions.find(_response.tid);
+    if (it == _transactions.end() || it->second.node != sender || it->second.eoj != _response.seoj) {
+        return false;
+    }
+    CTransaction transaction = std::move(it->second);
+    _transactions.erase(it);
+    // the link answers, the stall clock restarts for whatever is still out
+    _unanswered_since = _transactions.empty() ? -1 : now;
+
+    if (transaction.on_response) {
+        transaction.on_response(&_response);
+        return true;
+    }
+    if (esv != ESV_GET_RES && esv != ESV_GET_SNA) {
+        return true;
+    }
+
+    std::vector<uint8_t> missing = transaction.epcs;
+    std::vector<CCompletion> completions;
+    for (const auto &prop : _response.properties) {
+        missing.erase(std::remove(missing.begin(), missing.end(), prop.epc), missing.end());
+        CPropertyKey key { sender, transaction.eoj.code(), prop.epc };
+        if (prop.pdc > 0) {
+            _cache.store(key, prop.edt, prop.pdc, now);
+            detach(key, REQ_OK, prop.edt, prop.pdc, completions);
+        } else {
+            detach(key, REQ_NOT_AVAILABLE, nullptr, 0, completions);
+        }
+    }
+    // EPCs which the response left out
+    for (uint8_t epc : missing) {
+        detach(CPropertyKey { sender, transaction.eoj.code(), epc }, REQ_NOT_AVAILABLE, nullptr, 0, completions);
+    }
+    run(completions);
+    return true;
+}
+
+void CEchonetRequester::suspend()
+{
+    _suspended = true;
+    for (auto it = _transactions.begin(); it != _transactions.end(); ) {
+        CTransaction &transaction = it->second;
+        if (!transaction.frame.empty()) {
+            if (!transaction.parked) {
+                transaction.parked = true;
+                _parked.push_back(it->first);
+            }
+            ++it;
+            continue;
+        }
+        // Gets are asked again, coalesced with whatever is queued meanwhile
+        for (uint8_t epc : transaction.epcs) {
+            CPropertyKey key { transaction.node, transaction.eoj.code(), epc };
+            auto waiting = _waiting.find(key);
+            if (waiting != _waiting.end() && waiting->second.sent) {
+                waiting->second.sent = false;
+                _queued.push_back(key);
+            }
+        }
+        it = _transactions.erase(it);
+    }
+
+    // a Set selecting what the next Get reads must go out first again
+    std::sort(_parked.begin(), _parked.end(), [this](uint16_t a, uint16_t b) {
+        return (uint16_t)(a - _next_tid) < (uint16_t)(b - _next_tid);
+    });
+}
+
+void CEchonetRequester::expire(msec_t now)
+{
+    std::vector<CTransaction> expired;
+    for (auto it = _transactions.begin(); it != _transactions.end(); ) {
+        if (!it->second.parked && it->second.deadline <= now) {
+            expired.push_back(std::move(it->second));
+            it = _transactions.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    for (const auto &transaction : expired) {
+        if (transaction.on_response) {
+            transaction.on_response(nullptr);
+            continue;
+        }
+        std::vector<CCompletion> completions;
+        for (uint8_t epc : transaction.epcs) {
+            detach(CPropertyKey { transaction.node, transaction.eoj.code(), epc }, REQ_TIMEOUT, nullptr, 0,
+                   completions);
+        }
+        run(completions);
+    }
+}
+
+void CEchonetRequester::complete(const CPropertyKey &key, CRequestStatus status, const uint8_t *edt, uint8_t pdc)
+{
+    std::vector<CCompletion> completions;
+    detach(key, status, edt, pdc, completions);
+    run(completions);
+}
+
+void CEchonetRequester::detach(const CPropertyKey &key, CRequestStatus status, const uint8_t *edt, uint8_t pdc,
+                               std::vector<CCompletion> &out)
+{
+    auto it = _waiting.find(key);
+    if (it == _waiting.end()) {
+        return;
+    }
+    if (!it->second.sent && status == REQ_OK) {
+        // answered by an announcement before we asked, drop it from the queue
+        _queued.erase(std::remove(_queued.begin(), _queued.end(), key), _queued.end());
+    }
+
+    // edt is copied, callbacks may change the cache entry it points into
+    out.push_back(CCompletion { std::move(it->second.callbacks), status, std::vector<uint8_t>(edt, edt + pdc) });
+    _waiting.erase(it);
+}
+
+void CEchonetRequester::run(std::vector<CCompletion> &completions)
+{
+    for (auto &completion : completions) {
+        const uint8_t *edt = completion.edt.empty() ? nullptr : completion.edt.data();
+        for (auto &callback : completion.callbacks) {
+            callback(completion.status, edt, (uint8_t)completion.edt.size());
+        }
+    }
+}
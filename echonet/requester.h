@@ -0,0 +1,196 @@
+#ifndef _ECHONET_REQUESTER_H_
+#define _ECHONET_REQUESTER_H_
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "echonet.h"
+#include "frame.h"
+#include "node_index.h"
+#include "property_cache.h"
+
+enum CRequestStatus {
+    REQ_OK,
+    REQ_NOT_AVAILABLE,      // SNA or empty EDT
+    REQ_TIMEOUT,
+    REQ_SEND_FAILED,
+};
+
+// what the sender did with a frame
+enum CSendResult {
+    SEND_OK,
+    SEND_DEFERRED,          // not now, e.g. out of transmit budget. kept for the next flush()
+    SEND_FAILED,
+};
+
+/*
+  Get transactions on top of the property cache.
+
+  a request for a property which is fresh in the cache is answered at
+  once. a request for a property already queued or in flight waits for
+  that transaction. the remaining misses are collected until flush(),
+  which sends one multi-EPC Get (OPC > 1) per (node, EOJ). a Get the
+  sender defers stays queued, one it fails is completed REQ_SEND_FAILED.
+
+  suspend() holds everything while the dongle is being recovered: Gets
+  in flight go back to the queue and transact() frames are kept to be
+  sent again, so nothing times out because the link was down.
+
+  with a node index set, a Get for an EPC missing from the object's Get
+  property map fails at once instead of costing a round trip for SNA.
+ */
+class CEchonetRequester
+{
+public:
+    using msec_t = CPropertyCache::msec_t;
+    using callback_type = std::function<void(CRequestStatus status, const uint8_t *edt, uint8_t pdc)>;
+    using sender_type = std::function<CSendResult(const node_addr_t &node, const std::vector<uint8_t> &frame)>;
+    using frame_callback_type = std::function<void(const CEchonetFrame *response)>;
+    using observer_type = std::function<void(const node_addr_t &sender, const CEchonetFrame &frame, msec_t now)>;
+
+    static constexpr size_t MAX_EPC_PER_GET = 16;
+
+    CEchonetRequester(CPropertyCache &cache, sender_type sender, const CEoj &local_eoj = EOJ_CONTROLLER)
+        : _cache(cache), _sender(sender), _local_eoj(local_eoj), _next_tid(1), _timeout(20 * 1000),
+          _index(nullptr), _rejected(0), _suspended(false), _unanswered_since(-1)
+    {
+    }
+
+    void get(const node_addr_t &node, const CEoj &eoj, uint8_t epc, callback_type callback, msec_t now);
+
+    // returns the number of frames sent
+    int flush(msec_t now);
+
+    // sends one frame right away, bypassing the cache. callback gets the
+    // response, or nullptr on timeout. returns false if it was not sent.
+    bool transact(const node_addr_t &node, const CEoj &deoj, uint8_t esv, const CEchonetProperty *props, size_t count,
+                  frame_callback_type callback, msec_t now);
+
+    // sends one frame without waiting for an answer, e.g. to ECHONET_MULTICAST
+    bool send(const node_addr_t &node, const CEoj &deoj, uint8_t esv, const CEchonetProperty *props, size_t count);
+
+    // nothing is sent until resume(), in-flight requests are kept for then
+    void suspend();
+
+    void resume()
+    {
+        _suspended = false;
+    }
+
+    bool suspended() const
+    {
+        return _suspended;
+    }
+
+    // returns true if data answered one of our transactions
+    bool handle(const node_addr_t &sender, const std::vector<uint8_t> &data, msec_t now);
+
+    // fails transactions which were not answered in time
+    void expire(msec_t now);
+
+    void set_index(const CNodeIndex *index)
+    {
+        _index = index;
+    }
+
+    // sees every decoded frame before it is matched to a transaction
+    void set_frame_observer(observer_type observer)
+    {
+        _observer = std::move(observer);
+    }
+
+    // Gets answered from the node index without being sent
+    size_t rejected() const
+    {
+        return _rejected;
+    }
+
+    void set_timeout(msec_t timeout_msec)
+    {
+        _timeout = timeout_msec;
+    }
+
+    size_t in_flight() const
+    {
+        return _transactions.size();
+    }
+
+    size_t queued() const
+    {
+        return _queued.size();
+    }
+
+    // when the oldest request not followed by any answer was sent, -1 if
+    // every request so far was answered. unlike in_flight() it survives
+    // the requests timing out
+    msec_t unanswered_since() const
+    {
+        return _unanswered_since;
+    }
+
+private:
+    struct CWaitList
+    {
+        std::vector<callback_type> callbacks;
+        bool sent;
+    };
+
+    // waiters taken off _waiting, with the result they are to be given
+    struct CCompletion
+    {
+        std::vector<callback_type> callbacks;
+        CRequestStatus status;
+        std::vector<uint8_t> edt;
+    };
+
+    struct CTransaction
+    {
+        node_addr_t node;
+        CEoj eoj;
+        std::vector<uint8_t> epcs;
+        msec_t deadline;
+        frame_callback_type on_response;    // set for transact()
+        std::vector<uint8_t> frame;         // transact() only, to send again after suspend()
+        bool parked;
+    };
+
+    CPropertyCache &_cache;
+    sender_type _sender;
+    CEoj _local_eoj;
+    uint16_t _next_tid;
+    msec_t _timeout;
+    const CNodeIndex *_index;
+    observer_type _observer;
+    size_t _rejected;
+    bool _suspended;
+    std::vector<uint16_t> _parked;          // transact() tids to send again, oldest first
+    msec_t _unanswered_since;
+
+    std::unordered_map<CPropertyKey, CWaitList, CPropertyKeyHash> _waiting;
+    std::vector<CPropertyKey> _queued;
+    std::unordered_map<uint16_t, CTransaction> _transactions;
+    std::vector<uint8_t> _frame;
+    CEchonetFrame _response;
+
+    uint16_t allocate_tid();
+
+    void note_sent(msec_t now)
+    {
+        if (_unanswered_since < 0) {
+            _unanswered_since = now;
+        }
+    }
+
+    void complete(const CPropertyKey &key, CRequestStatus status, const uint8_t *edt, uint8_t pdc);
+
+    // detach() every key of a transaction first and run() them after, so
+    // a callback asking for the same key again gets a waiter of its own
+    void detach(const CPropertyKey &key, CRequestStatus status, const uint8_t *edt, uint8_t pdc,
+                std::vector<CCompletion> &out);
+
+    static void run(std::vector<CCompletion> &completions);
+};
+
+#endif
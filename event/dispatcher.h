@@ -0,0 +1,87 @@
+#ifndef _EVENT_DISPATCHER_H_
+#define _EVENT_DISPATCHER_H_
+
+#include <memory>
+#include <vector>
+
+#include "event_base.h"
+#include "event_filter.h"
+
+/*
+  tries each event type in turn on the head of a buffer.
+  the list is expanded at compile time, so adding an event type only
+  adds one more magic number comparison.
+ */
+template <class... Events>
+class CEventDispatcher
+{
+public:
+    using ptr_type = std::unique_ptr<CEventBase>;
+
+    /*
+      EV_MATCHED      : out holds the event, next_pos points just after it
+      EV_UNMATCHED    : not a known event, next_pos points after the line
+      EV_FILTERED     : a known event the filter dropped, next_pos points after it
+      EV_SHORT_LENGTH : more data is needed
+     */
+    static CEventMatchResult parse(const std::vector<char> &buf, long start, long length, ptr_type &out, long &next_pos,
+                                   CEventFilter *filter = nullptr)
+    {
+        if (!CEventBase::valid_buffer_params(buf, start, length)) {
+            return EV_ERROR;
+        }
+
+        CEventMatchResult result = EV_UNMATCHED;
+        (void)(try_parse<Events>(buf, start, length, out, next_pos, filter, result) || ...);
+        if (result != EV_UNMATCHED) {
+            return result;
+        }
+
+        long line_end = CEventBase::find_line_end(buf, start, length);
+        if (line_end < 0) {
+            return EV_SHORT_LENGTH;
+        }
+        next_pos = line_end;
+        return EV_UNMATCHED;
+    }
+
+private:
+    template <class T>
+    static bool try_parse(const std::vector<char> &buf, long start, long length, ptr_type &out, long &next_pos,
+                          CEventFilter *filter, CEventMatchResult &result)
+    {
+        auto magic = CEventParser<T>::compare_magic_number(buf, start, length);
+        if (magic == EV_SHORT_LENGTH) {
+            result = EV_SHORT_LENGTH;
+            return false;
+        } else if (magic != EV_MATCHED) {
+            return false;
+        }
+
+        if (filter != nullptr) {
+            // decided on the raw characters, before the event is allocated
+            auto verdict = filter->check(CEventParser<T>::get_event_type(), buf, start, length, next_pos,
+                                         &CEventParser<T>::skip);
+            if (verdict == EV_UNMATCHED) {
+                return false;
+            } else if (verdict != EV_MATCHED) {
+                result = verdict;
+                return true;
+            }
+        }
+
+        auto ev = CEventParser<T>::create_instance();
+        auto parsed = ev->parse(buf, start, length, next_pos);
+        if (parsed == EV_MATCHED) {
+            out = std::move(ev);
+            result = EV_MATCHED;
+            return true;
+        } else if (parsed == EV_SHORT_LENGTH) {
+            result = EV_SHORT_LENGTH;
+            return true;
+        }
+        return false;
+    }
+};
+
+#endif
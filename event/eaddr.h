@@ -0,0 +1,16 @@
+#ifndef _EVENT_EADDR_H_
+#define _EVENT_EADDR_H_
+
+#include "fields.h"
+
+// EADDR followed by one <IPADDR> per line
+class CEvEADDR : public CTypedEvent<CEvEADDR, EVT_EADDR,
+                                    sk_list_field<f_addresses, sk_ipv6>>
+{
+public:
+    static constexpr char event_name[] = "EADDR";
+
+    const std::vector<sk_ipv6::value_type> &addresses() const { return get<f_addresses>(); }
+};
+
+#endif
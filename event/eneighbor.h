@@ -0,0 +1,18 @@
+#ifndef _EVENT_ENEIGHBOR_H_
+#define _EVENT_ENEIGHBOR_H_
+
+#include "fields.h"
+
+// ENEIGHBOR followed by one "<IPADDR> <MAC>" per line
+class CEvENEIGHBOR : public CTypedEvent<CEvENEIGHBOR, EVT_ENEIGHBOR,
+                                        sk_list_field<f_neighbors, sk_pair<sk_ipv6, sk_mac>>>
+{
+public:
+    static constexpr char event_name[] = "ENEIGHBOR";
+
+    using neighbor_type = sk_pair<sk_ipv6, sk_mac>::value_type;
+
+    const std::vector<neighbor_type> &neighbors() const { return get<f_neighbors>(); }
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef _EVENT_EPANDESC_H_
+#define _EVENT_EPANDESC_H_
+
+#include "fields.h"
+
+// EPANDESC
+//   Channel:<CH>
+//   Channel Page:<PAGE>
+//   Pan ID:<PANID>
+//   Addr:<MAC>
+//   LQI:<LQI>
+//   [PairID:<ID>]
+class CEvEPANDESC : public CTypedEvent<CEvEPANDESC, EVT_EPANDESC,
+                                       sk_field<f_channel, sk_hex<2>>,
+                                       sk_field<f_channel_page, sk_hex<2>>,
+                                       sk_field<f_pan_id, sk_hex<4>>,
+                                       sk_field<f_addr, sk_mac>,
+                                       sk_field<f_lqi, sk_hex<2>>,
+                                       sk_optional_field<f_pair_id, sk_hex<8>>>
+{
+public:
+    static constexpr char event_name[] = "EPANDESC";
+
+    uint8_t channel() const { return get<f_channel>(); }
+    uint8_t channel_page() const { return get<f_channel_page>(); }
+    uint16_t pan_id() const { return get<f_pan_id>(); }
+    uint64_t addr() const { return get<f_addr>(); }
+    uint8_t lqi() const { return get<f_lqi>(); }
+    const std::optional<uint32_t> &pair_id() const { return get<f_pair_id>(); }
+};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef _EVENT_ERXTCP_H_
+#define _EVENT_ERXTCP_H_
+
+#include "fields.h"
+
+// ERXTCP <SENDER> <RPORT> <LPORT> <DATALEN> <DATA>
+class CEvERXTCP : public CTypedEvent<CEvERXTCP, EVT_ERXTCP,
+                                     sk_field<f_sender, sk_ipv6>,
+                                     sk_field<f_rport, sk_hex<4>>,
+                                     sk_field<f_lport, sk_hex<4>>,
+                                     sk_field<f_data, sk_payload<>>>
+{
+public:
+    static constexpr char event_name[] = "ERXTCP";
+
+    const sk_ipv6::value_type &sender() const { return get<f_sender>(); }
+    uint16_t rport() const { return get<f_rport>(); }
+    uint16_t lport() const { return get<f_lport>(); }
+    const std::vector<uint8_t> &data() const { return get<f_data>(); }
+};
+
+#endif
@@ -1,59 +1,28 @@
 #ifndef _EVENT_ERXUDP_H_
 #define _EVENT_ERXUDP_H_
 
-#include "event_base.h"
-
-class CEvERXUDP : public CEventBase
+#include "fields.h"
+
+// ERXUDP <SENDER> <DEST> <RPORT> <LPORT> <SENDERLLA> <SECURED> <DATALEN> <DATA>
+class CEvERXUDP : public CTypedEvent<CEvERXUDP, EVT_ERXUDP,
+                                     sk_field<f_sender, sk_ipv6>,
+                                     sk_field<f_dest, sk_ipv6>,
+                                     sk_field<f_rport, sk_hex<4>>,
+                                     sk_field<f_lport, sk_hex<4>>,
+                                     sk_field<f_senderlla, sk_mac>,
+                                     sk_field<f_secured, sk_flag>,
+                                     sk_field<f_data, sk_payload<>>>
 {
 public:
-    static constexpr char *event_name = "ERXUDP";
-    static constexpr char magic_number[] = {
-        'E', 'R', 'X', 'U', 'D', 'P', ' ',
-    };
-
-    static const char *get_event_name() 
-    {
-        return event_name;
-    }
-
-    static const char *get_magic_number() 
-    {
-        return magic_number;
-    }
-
-    static const char *get_magic_number_size()
-    {
-        return sizeof(magic_number);
-    }
-
-    CEventMatchResult parse(std::vector<char> &buf, long start, long length, long &next_pos) 
-    {
-        const char *field_names[] = {
-            "SENDER",
-            "DEST",
-            "RPORT",
-            "LPORT",
-            "SENDERLLA",
-            "SECURED"
-        };
-        const char *length_name = "DATALEN";
-        const char *data_name = "DATA";
-
-        long next = start;
-        auto result = parseParams(field_names, buf, start, length, length_name, data_name, next);
-        if (result != EV_MATCHED) {
-            return result;
-        }
-        long next_length = length - (next - start);
-        result = parseData(buf, next, next_length, length_name, data_name, next);
-        if (result != EV_MATCHED) {
-            return result;
-        }
-
-        next_pos = next;
-        return EV_MATCHED;
-    }
-    
+    static constexpr char event_name[] = "ERXUDP";
+
+    const sk_ipv6::value_type &sender() const { return get<f_sender>(); }
+    const sk_ipv6::value_type &dest() const { return get<f_dest>(); }
+    uint16_t rport() const { return get<f_rport>(); }
+    uint16_t lport() const { return get<f_lport>(); }
+    uint64_t senderlla() const { return get<f_senderlla>(); }
+    bool secured() const { return get<f_secured>(); }
+    const std::vector<uint8_t> &data() const { return get<f_data>(); }
 };
 
 #endif
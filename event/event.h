@@ -0,0 +1,41 @@
+#ifndef _EVENT_EVENT_H_
+#define _EVENT_EVENT_H_
+
+#include "fields.h"
+
+// EVENT <NUM> <SENDER> [<SIDE>] [<PARAM>]
+// SIDE (B route / HAN) is printed by firmware 1.2.10 and later
+class CEvEVENT : public CTypedEvent<CEvEVENT, EVT_EVENT,
+                                    sk_field<f_num, sk_hex<2>>,
+                                    sk_field<f_sender, sk_ipv6>,
+                                    sk_optional_field<f_side, sk_digit>,
+                                    sk_optional_field<f_param, sk_hex<2>>>
+{
+public:
+    static constexpr char event_name[] = "EVENT";
+
+    enum {
+        NS_RECEIVED         = 0x01,
+        NA_RECEIVED         = 0x02,
+        ECHO_REQ_RECEIVED   = 0x05,
+        ED_SCAN_DONE        = 0x1F,
+        BEACON_RECEIVED     = 0x20,
+        UDP_SENT            = 0x21,
+        ACTIVE_SCAN_DONE    = 0x22,
+        PANA_FAILED         = 0x24,
+        PANA_CONNECTED      = 0x25,
+        SESSION_END_REQ     = 0x26,
+        SESSION_ENDED       = 0x27,
+        SESSION_END_TIMEOUT = 0x28,
+        SESSION_EXPIRED     = 0x29,
+        TX_LIMIT_REACHED    = 0x32,
+        TX_LIMIT_RELEASED   = 0x33,
+    };
+
+    uint8_t num() const { return get<f_num>(); }
+    const sk_ipv6::value_type &sender() const { return get<f_sender>(); }
+    const std::optional<uint8_t> &side() const { return get<f_side>(); }
+    const std::optional<uint8_t> &param() const { return get<f_param>(); }
+};
+
+#endif
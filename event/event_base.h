@@ -5,121 +5,111 @@
 #include <cstring>
 #include <string>
 #include <vector>
-#include <map>
 #include <memory>
 
+#include "../serialize/formats.h"
+
 enum CEventMatchResult {
     EV_MATCHED,
     EV_UNMATCHED,
     EV_SHORT_LENGTH,
     EV_ERROR,
+    EV_FILTERED,        // a known event nobody subscribed to, skipped unparsed
 };
 
-template <class T>
-class CEventParser 
-{
-public:
-    using ptr_type = std::unique_ptr<T>;
-    
-    static const char *get_event_name() 
-    {
-        return T::get_event_name();
-    }
-    
-    static const char *get_magic_number()
-    {
-        return T::get_magic_number();
-    }
-    
-    static const long get_magic_number_size()
-    {
-        return T::get_magic_number_size();
-    }
-    
-
-    static CEventMatchResult compare_magic_number(const std::vector<char> &buf, const long start, const long length)
-    {
-        return bufncmp(get_magic_number(), buf, start, length, get_magic_number_size());
-    }
-
-    static ptr_type create_instance() 
-    {
-        ptr_type pointer(new T());
-        return std::move(pointer);
-    }
-    
+enum CEventType {
+    EVT_UNKNOWN,
+    EVT_ERXUDP,
+    EVT_ERXTCP,
+    EVT_EVENT,
+    EVT_EPANDESC,
+    EVT_EADDR,
+    EVT_ENEIGHBOR,
+    EVT_OK,
+    EVT_FAIL,
 };
 
 class CEventBase
 {
 public:
+    virtual ~CEventBase() = default;
+
     // will be overrided
-    virtual CEventMatchResult parse(std::vector<char> &buf, long start, long length, long &next_pos) = 0;
+    virtual CEventMatchResult parse(const std::vector<char> &buf, long start, long length, long &next_pos) = 0;
 
-    void print() const;
-    
-protected:
-    std::map<std::string, std::vector<char>> _values;
+    virtual CEventType get_type() const = 0;
+
+    virtual const char *get_name() const = 0;
 
-    template <int count>
-    CEventMatchResult parseParams(const char *(&param_names)[count], const std::vector<char> &buf, const long buf_start, const long buf_length, long &out_next_pos);
+    // false if the event does not fit the format, out is then unchanged
+    virtual bool serialize(COutputBuffer &out, CSerialFormat format) const = 0;
 
-    CEventMatchResult parseData(const std::vector<char> &buf, const long buf_start, const long buf_length, const char *length_name, const char *data_name, long &out_next_pos);
+    // one JSON line to stderr
+    void print() const;
 
-    template <class Traits>
-        void print(std::basic_ostream<char, Traits> &ss, std::vector<char>::iterator begin, std::vector<char>::iterator end) const;
-        
-    bool valid_buffer_params(const std::vector<char> &buf, const long buf_start, const long buf_length) const
+public:
+    static bool valid_buffer_params(const std::vector<char> &buf, const long buf_start, const long buf_length)
     {
         // if buf_length == 0, it will be VALID
-        return buf_start < 0 || buf_length < 0 || (buf_start + buf_length) > (signed)buf.size();
+        return buf_start >= 0 && buf_length >= 0 && (buf_start + buf_length) <= (signed)buf.size();
     }
 
-    void shift_position(const long n, long &start, long &length) const
+    static CEventMatchResult bufncmp(const char *s1, const std::vector<char> &s2_buf, const long buf_start, const long buf_length, const long compare_length);
+
+    template <long size>
+        static CEventMatchResult bufncmp(const char (&s1)[size], const std::vector<char> &s2_buf, const long buf_start, const long buf_length)
     {
-        assert(length >= n);
-        start += n;
-        length -= n;
+        return bufncmp(s1, s2_buf, buf_start, buf_length, size);
     }
-    
-    CEventMatchResult shift_position(const std::vector<char> &buf, long &start, long &length, const char *str, const long count) const
+
+    // returns the position just after the next CRLF, or -1 if the line is incomplete
+    static long find_line_end(const std::vector<char> &buf, const long buf_start, const long buf_length);
+};
+
+template <class T>
+class CEventParser
+{
+public:
+    using ptr_type = std::unique_ptr<T>;
+
+    static const char *get_event_name()
     {
-        assert((signed)buf.size() >= start + count);
-        if (bufncmp(str, buf, start, length, count) != EV_MATCHED) {
-            return EV_UNMATCHED;
-        }
-        shift_position(count, start, length);
-        return EV_MATCHED;
+        return T::get_event_name();
     }
 
-    template <long count>
-    CEventMatchResult shift_position(const std::vector<char> &buf, long &start, long &length, const char (&str)[count]) const
+    static const char *get_magic_number()
     {
-        return shift_position(buf, start, length, str, count);
+        return T::get_magic_number();
     }
-    
-    CEventMatchResult shift_space(const std::vector<char> &buf, long &start, long &length) const
+
+    static long get_magic_number_size()
     {
-        const char space[] = {' '};
-        return shift_position(buf, start, length, space);
+        return T::get_magic_number_size();
     }
-    
-    CEventMatchResult shift_crlf(const std::vector<char> &buf, long &start, long &length) const
+
+
+    static CEventType get_event_type()
     {
-        const char crlf[] = {'\r', '\n'};
-        return shift_position(buf, start, length, crlf);
+        return T::get_event_type();
     }
 
-    long find_separator(const std::vector<char> &buf, const long buf_start, const long buf_length, long &out_crlf_pos) const;
+    static CEventMatchResult compare_magic_number(const std::vector<char> &buf, const long start, const long length)
+    {
+        return CEventBase::bufncmp(get_magic_number(), buf, start, length, get_magic_number_size());
+    }
 
-public:
-    static CEventMatchResult bufncmp(const char *s1, const std::vector<char> &s2_buf, const long buf_start, const long buf_length, const long compare_length);
+    static ptr_type create_instance()
+    {
+        return ptr_type(new T());
+    }
 
-    template <long size>
-        static CEventMatchResult bufncmp(const char (&s1)[size], const std::vector<char> &s2_buf, const long buf_start, const long buf_length)
+    // parses the event at start only to find where it ends, nothing is kept
+    static CEventMatchResult skip(const std::vector<char> &buf, long start, long length, long &next_pos)
     {
-        return bufncmp(s1, s2_buf, buf_start, buf_length, size);
-    }  
+        T ev;
+        return ev.parse(buf, start, length, next_pos);
+    }
+
 };
 
 #endif
@@ -0,0 +1,258 @@
+#include <cstring>
+
+#include "event_base.h"
+#include "event_filter.h"
+#include "erxudp.h"
+
+namespace {
+
+/*
+  ERXUDP <SENDER> <DEST> <RPORT> <LPORT> <SENDERLLA> <SECURED> <DATALEN> <DATA>
+  every field before DATA has a fixed width, so the columns follow from the schema
+ */
+constexpr long SENDER_OFFSET = CEvERXUDP::offset_of<f_sender>();
+constexpr long RPORT_OFFSET = CEvERXUDP::offset_of<f_rport>();
+constexpr long LPORT_OFFSET = CEvERXUDP::offset_of<f_lport>();
+constexpr long DATALEN_OFFSET = CEvERXUDP::offset_of<f_data>();
+constexpr long DATA_OFFSET = DATALEN_OFFSET + sk_payload<>::header_width;
+
+// the space in front of every field
+constexpr long SEPARATORS[] = {
+    SENDER_OFFSET - 1,
+    CEvERXUDP::offset_of<f_dest>() - 1,
+    RPORT_OFFSET - 1,
+    LPORT_OFFSET - 1,
+    CEvERXUDP::offset_of<f_senderlla>() - 1,
+    CEvERXUDP::offset_of<f_secured>() - 1,
+    DATALEN_OFFSET - 1,
+    DATA_OFFSET - 1,
+};
+
+static_assert(SENDER_OFFSET == 7 && RPORT_OFFSET == 87 && LPORT_OFFSET == 92
+              && DATALEN_OFFSET == 116 && DATA_OFFSET == 121, "ERXUDP columns as SKSTACK prints them");
+static_assert(SEPARATORS[1] == 46 && SEPARATORS[4] == 96 && SEPARATORS[5] == 113, "ERXUDP separators");
+
+// ECHONET Lite format 1 (echonet/echonet.h builds on this layer, not the other way round)
+const int ECHONET_HEADER_SIZE = 12;
+const int EHD1 = 0x10;
+const int EHD2 = 0x81;
+const int ESV_SETGET_SNA = 0x5E;
+const int ESV_SETGET = 0x6E;
+const int ESV_SETGET_RES = 0x7E;
+
+int hex_value(const char *p, int digits)
+{
+    int v = 0;
+    uint8_t bad = 0;
+    for (int i = 0; i < digits; ++i) {
+        uint8_t d = sk_detail::hex_table[(uint8_t)p[i]];
+        bad |= d;
+        v = (v << 4) | (d & 0x0F);
+    }
+    return (bad & 0xF0) ? -1 : v;
+}
+
+void format_ipv6(char (&out)[39], const sk_ipv6::value_type &addr)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    char *p = out;
+    for (int i = 0; i < 16; ++i) {
+        *p++ = digits[addr[i] >> 4];
+        *p++ = digits[addr[i] & 0x0F];
+        if ((i & 1) && i != 15) {
+            *p++ = ':';
+        }
+    }
+}
+
+}
+
+CEventFilter::CEventFilter(CPayloadEncoding encoding)
+    : _encoding(encoding), _types(0), _next_id(1), _stats {}
+{
+}
+
+int CEventFilter::subscribe(const CSubscription &subscription)
+{
+    if (_entries.size() >= MAX_SUBSCRIPTIONS) {
+        return E_FILTER_FULL;
+    }
+    CEntry entry;
+    entry.id = _next_id++;
+    entry.subscription = subscription;
+    if (subscription.sender) {
+        format_ipv6(entry.sender, *subscription.sender);
+    }
+    _entries.push_back(entry);
+    update_types();
+    return entry.id;
+}
+
+void CEventFilter::unsubscribe(int id)
+{
+    for (auto it = _entries.begin(); it != _entries.end(); ++it) {
+        if (it->id == id) {
+            _entries.erase(it);
+            break;
+        }
+    }
+    update_types();
+}
+
+void CEventFilter::update_types()
+{
+    _types = 0;
+    for (const auto &entry : _entries) {
+        _types |= entry.subscription.types == 0 ? ~0u : entry.subscription.types;
+    }
+}
+
+CEventMatchResult CEventFilter::check(CEventType type, const std::vector<char> &buf, long start, long length, long &next_pos,
+                                      skip_type skip)
+{
+    if (!CEventBase::valid_buffer_params(buf, start, length)) {
+        return EV_ERROR;
+    }
+
+    const uint32_t bit = CSubscription::type_bit(type);
+    uint64_t candidates = 0;
+    if (_types & bit) {
+        for (size_t i = 0; i < _entries.size(); ++i) {
+            const uint32_t types = _entries[i].subscription.types;
+            if (types == 0 || (types & bit)) {
+                candidates |= 1ULL << i;
+            }
+        }
+    }
+
+    if (type == EVT_ERXUDP) {
+        long event_length = 0;
+        auto result = check_erxudp(buf.data() + start, length, candidates, event_length);
+        if (result == EV_FILTERED) {
+            next_pos = start + event_length;
+            return result;
+        } else if (result != EV_MATCHED || candidates != 0) {
+            if (result == EV_MATCHED) {
+                ++_stats.passed;
+            }
+            return result;
+        }
+        // a layout the columns do not fit and nobody wants, dropped on the type below
+    }
+
+    if (candidates == 0) {
+        // EPANDESC and ENEIGHBOR run over several lines, only the parser knows where they end
+        auto result = skip(buf, start, length, next_pos);
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        return drop(FILTER_TYPE);
+    }
+    ++_stats.passed;
+    return EV_MATCHED;
+}
+
+CEventMatchResult CEventFilter::check_erxudp(const char *line, long length, uint64_t candidates, long &event_length)
+{
+    // anything which does not look like the usual layout is left to the parser
+    for (long offset : SEPARATORS) {
+        if (offset < length && line[offset] != ' ') {
+            return EV_MATCHED;
+        }
+    }
+    if (length < DATA_OFFSET) {
+        return std::memchr(line, '\n', length) != nullptr ? EV_MATCHED : EV_SHORT_LENGTH;
+    }
+
+    const int datalen = hex_value(line + DATALEN_OFFSET, 4);
+    if (datalen < 0) {
+        return EV_MATCHED;
+    }
+    const bool hex = _encoding == PAYLOAD_ASCII_HEX;
+    const long data_chars = hex ? (long)datalen * 2 : datalen;
+    event_length = DATA_OFFSET + data_chars + 2;
+    if (length < event_length) {
+        if (hex && std::memchr(line + DATA_OFFSET, '\n', length - DATA_OFFSET) != nullptr) {
+            return EV_MATCHED;
+        }
+        return EV_SHORT_LENGTH;
+    }
+
+    if (candidates == 0) {
+        return drop(FILTER_TYPE);
+    }
+
+    // header stage
+    const int rport = hex_value(line + RPORT_OFFSET, 4);
+    const int lport = hex_value(line + LPORT_OFFSET, 4);
+    bool payload_needed = false;
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        if (!(candidates & (1ULL << i))) {
+            continue;
+        }
+        const CSubscription &sub = _entries[i].subscription;
+        if ((sub.sender && std::memcmp(line + SENDER_OFFSET, _entries[i].sender, sizeof(_entries[i].sender)) != 0)
+            || (sub.rport && *sub.rport != rport)
+            || (sub.lport && *sub.lport != lport)) {
+            candidates &= ~(1ULL << i);
+            continue;
+        }
+        if (!sub.seoj && !sub.esv && !sub.epc) {
+            // nothing left to check
+            return EV_MATCHED;
+        }
+        payload_needed = true;
+    }
+    if (!payload_needed) {
+        return drop(FILTER_HEADER);
+    }
+
+    // payload stage, straight from the DATA characters
+    const char *data = line + DATA_OFFSET;
+    auto byte_at = [&](long i) -> int {
+        return hex ? hex_value(data + i * 2, 2) : (uint8_t)data[i];
+    };
+    if (datalen < ECHONET_HEADER_SIZE || byte_at(0) != EHD1 || byte_at(1) != EHD2) {
+        return drop(FILTER_PAYLOAD);
+    }
+    const uint32_t seoj = ((uint32_t)byte_at(4) << 16) | ((uint32_t)byte_at(5) << 8) | (uint32_t)byte_at(6);
+    const int esv = byte_at(10);
+
+    uint64_t epcs[4] = {};
+    // SetGet frames carry a second property list
+    const int lists = (esv == ESV_SETGET_SNA || esv == ESV_SETGET || esv == ESV_SETGET_RES) ? 2 : 1;
+    long pos = ECHONET_HEADER_SIZE - 1;
+    for (int list = 0; list < lists && pos < datalen; ++list) {
+        int opc = byte_at(pos++);
+        for (int i = 0; i < opc && pos + 2 <= datalen; ++i) {
+            int epc = byte_at(pos);
+            int pdc = byte_at(pos + 1);
+            if (epc < 0 || pdc < 0) {
+                break;
+            }
+            epcs[epc >> 6] |= 1ULL << (epc & 0x3F);
+            pos += 2 + pdc;
+        }
+    }
+
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        if (!(candidates & (1ULL << i))) {
+            continue;
+        }
+        const CSubscription &sub = _entries[i].subscription;
+        if (sub.seoj) {
+            const uint32_t mask = (*sub.seoj & 0xFF) ? 0xFFFFFF : 0xFFFF00;
+            if ((seoj & mask) != *sub.seoj) {
+                continue;
+            }
+        }
+        if (sub.esv && *sub.esv != esv) {
+            continue;
+        }
+        if (sub.epc && !((epcs[*sub.epc >> 6] >> (*sub.epc & 0x3F)) & 1)) {
+            continue;
+        }
+        return EV_MATCHED;
+    }
+    return drop(FILTER_PAYLOAD);
+}
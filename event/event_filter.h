@@ -0,0 +1,108 @@
+#ifndef _EVENT_EVENT_FILTER_H_
+#define _EVENT_EVENT_FILTER_H_
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "schema.h"
+
+/*
+  what one consumer wants to see. unset criteria match anything.
+  sender, ports, SEOJ, ESV and EPC only restrict ERXUDP; other event
+  types are selected by types alone.
+ */
+struct CSubscription
+{
+    uint32_t types = 0;                         // bit per CEventType (type_bit()), 0 for all
+    std::optional<sk_ipv6::value_type> sender;
+    std::optional<uint16_t> rport;
+    std::optional<uint16_t> lport;
+    std::optional<uint32_t> seoj;               // EOJ code, instance 0 matches any instance
+    std::optional<uint8_t> esv;
+    std::optional<uint8_t> epc;                 // any of the frame's properties
+
+    static constexpr uint32_t type_bit(CEventType type)
+    {
+        return 1u << type;
+    }
+};
+
+enum CFilterStage {
+    FILTER_TYPE,        // event type, right after the magic number
+    FILTER_HEADER,      // ERXUDP sender and ports at their fixed offsets
+    FILTER_PAYLOAD,     // ECHONET Lite header and EPCs read from the raw DATA
+    FILTER_STAGE_COUNT,
+};
+
+struct CFilterStats
+{
+    uint64_t passed;
+    uint64_t dropped[FILTER_STAGE_COUNT];
+};
+
+enum {
+    E_FILTER_FULL = -1,
+};
+
+/*
+  decides whether an event is worth parsing before anything is decoded
+  or allocated. each stage drops the event as soon as no subscription
+  can match any more, so most unwanted ERXUDP never reach the DATA.
+ */
+class CEventFilter
+{
+public:
+    static constexpr size_t MAX_SUBSCRIPTIONS = 64;
+
+    CEventFilter(CPayloadEncoding encoding = PAYLOAD_ASCII_HEX);
+
+    // returns an id for unsubscribe(), or E_FILTER_FULL
+    int subscribe(const CSubscription &subscription);
+
+    void unsubscribe(int id);
+
+    // finds the end of an event of a given type, see CEventParser::skip
+    using skip_type = CEventMatchResult (*)(const std::vector<char> &buf, long start, long length, long &next_pos);
+
+    /*
+      the event of type at start, its magic number already matched:
+      EV_MATCHED      : parse it
+      EV_FILTERED     : drop it, next_pos points after it
+      EV_SHORT_LENGTH : more data is needed to decide
+      EV_UNMATCHED    : skip could not find the end of a dropped event
+     */
+    CEventMatchResult check(CEventType type, const std::vector<char> &buf, long start, long length, long &next_pos,
+                            skip_type skip);
+
+    const CFilterStats &get_stats() const
+    {
+        return _stats;
+    }
+
+private:
+    struct CEntry
+    {
+        int id;
+        CSubscription subscription;
+        char sender[39];            // as SKSTACK prints it, compared with memcmp
+    };
+
+    CPayloadEncoding _encoding;
+    std::vector<CEntry> _entries;
+    uint32_t _types;                // union of every subscription's types
+    int _next_id;
+    CFilterStats _stats;
+
+    void update_types();
+
+    CEventMatchResult check_erxudp(const char *line, long length, uint64_t candidates, long &event_length);
+
+    CEventMatchResult drop(CFilterStage stage)
+    {
+        ++_stats.dropped[stage];
+        return EV_FILTERED;
+    }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef _EVENT_READER_H_
+#define _EVENT_READER_H_
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "event_base.h"
+#include "event_filter.h"
+#include "../serial/serial.h"
+
+/*
+  keeps the bytes read from the port and cuts them into events.
+  lines which are not events (command echo back, EVER, ...) are skipped,
+  and so are the events the filter drops.
+
+  the buffer grows up to max_capacity. a line longer than that can only be
+  noise, it is thrown away up to the next CRLF and counted in discarded().
+ */
+template <class Dispatcher>
+class CEventReader
+{
+public:
+    using ptr_type = typename Dispatcher::ptr_type;
+
+    explicit CEventReader(long capacity = 4096, long max_capacity = 65536)
+        : _buf(capacity), _max_capacity(max_capacity < capacity ? capacity : max_capacity),
+          _begin(0), _end(0), _skip_line(false), _discarded(0), _filter(nullptr)
+    {
+    }
+
+    void set_filter(CEventFilter *filter)
+    {
+        _filter = filter;
+    }
+
+    // blocks up to the port timeout, returns the value of CSerial::read
+    long read_from(CSerial &serial)
+    {
+        compact();
+        if (_end == (long)_buf.size()) {
+            if ((long)_buf.size() < _max_capacity) {
+                _buf.resize(std::min<long>(_buf.size() * 2, _max_capacity));
+            } else {
+                overflow();
+            }
+        }
+        long len = serial.read(_buf, _end, 1);
+        if (len > 0) {
+            _end += len;
+            if (_skip_line) {
+                skip_line();
+            }
+        }
+        return len;
+    }
+
+    // EV_MATCHED with an event in out, EV_SHORT_LENGTH when no complete event is buffered
+    CEventMatchResult next(ptr_type &out)
+    {
+        while (_begin < _end) {
+            long next_pos = _begin;
+            auto result = Dispatcher::parse(_buf, _begin, _end - _begin, out, next_pos, _filter);
+            if (result == EV_MATCHED) {
+                _begin = next_pos;
+                return EV_MATCHED;
+            } else if (result == EV_UNMATCHED || result == EV_FILTERED) {
+                _begin = next_pos;
+                continue;
+            }
+            return result;
+        }
+        return EV_SHORT_LENGTH;
+    }
+
+    void clear()
+    {
+        _begin = _end = 0;
+        _skip_line = false;
+    }
+
+    // bytes thrown away because a line did not fit in max_capacity
+    unsigned long long discarded() const
+    {
+        return _discarded;
+    }
+
+private:
+    std::vector<char> _buf;
+    long _max_capacity;
+    long _begin;
+    long _end;
+    bool _skip_line;            // the tail of an overlong line is still coming
+    unsigned long long _discarded;
+    CEventFilter *_filter;
+
+    // the buffer is full and holds no complete event: drop the head line,
+    // or all of it and whatever follows until a CRLF comes
+    void overflow()
+    {
+        _skip_line = true;
+        skip_line();
+        compact();
+    }
+
+    void skip_line()
+    {
+        long line_end = CEventBase::find_line_end(_buf, _begin, _end - _begin);
+        if (line_end < 0) {
+            // a CR at the very end may belong to the CRLF we are looking for
+            long keep = _end > _begin && _buf[_end - 1] == '\r' ? 1 : 0;
+            _discarded += _end - _begin - keep;
+            _begin = _end - keep;
+            return;
+        }
+        _discarded += line_end - _begin;
+        _begin = line_end;
+        _skip_line = false;
+    }
+
+    void compact()
+    {
+        if (_begin == 0) {
+            return;
+        }
+        std::memmove(_buf.data(), _buf.data() + _begin, _end - _begin);
+        _end -= _begin;
+        _begin = 0;
+    }
+};
+
+#endif
@@ -0,0 +1,32 @@
+#ifndef _EVENT_FIELDS_H_
+#define _EVENT_FIELDS_H_
+
+#include "schema.h"
+
+// space separated parameters
+SK_FIELD_TAG(f_sender,    "SENDER",    " ");
+SK_FIELD_TAG(f_dest,      "DEST",      " ");
+SK_FIELD_TAG(f_rport,     "RPORT",     " ");
+SK_FIELD_TAG(f_lport,     "LPORT",     " ");
+SK_FIELD_TAG(f_senderlla, "SENDERLLA", " ");
+SK_FIELD_TAG(f_secured,   "SECURED",   " ");
+SK_FIELD_TAG(f_data,      "DATA",      " ");
+SK_FIELD_TAG(f_num,       "NUM",       " ");
+SK_FIELD_TAG(f_side,      "SIDE",      " ");
+SK_FIELD_TAG(f_param,     "PARAM",     " ");
+SK_FIELD_TAG(f_value,     "VALUE",     " ");
+SK_FIELD_TAG(f_error,     "ERROR",     " ER");
+
+// EPANDESC lines
+SK_FIELD_TAG(f_channel,      "Channel",      "\r\n  Channel:");
+SK_FIELD_TAG(f_channel_page, "Channel Page", "\r\n  Channel Page:");
+SK_FIELD_TAG(f_pan_id,       "Pan ID",       "\r\n  Pan ID:");
+SK_FIELD_TAG(f_addr,         "Addr",         "\r\n  Addr:");
+SK_FIELD_TAG(f_lqi,          "LQI",          "\r\n  LQI:");
+SK_FIELD_TAG(f_pair_id,      "PairID",       "\r\n  PairID:");
+
+// one entry per line
+SK_FIELD_TAG(f_addresses, "ADDR",     "\r\n");
+SK_FIELD_TAG(f_neighbors, "NEIGHBOR", "\r\n");
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef _EVENT_RESPONSE_H_
+#define _EVENT_RESPONSE_H_
+
+#include "fields.h"
+
+// OK [<VALUE>]
+class CEvOK : public CTypedEvent<CEvOK, EVT_OK,
+                                 sk_optional_field<f_value, sk_hex<2>>>
+{
+public:
+    static constexpr char event_name[] = "OK";
+
+    const std::optional<uint8_t> &value() const { return get<f_value>(); }
+};
+
+// FAIL ER<NN>
+class CEvFAIL : public CTypedEvent<CEvFAIL, EVT_FAIL,
+                                   sk_field<f_error, sk_dec<2>>>
+{
+public:
+    static constexpr char event_name[] = "FAIL";
+
+    enum {
+        ER_UNSUPPORTED    = 4,
+        ER_WRONG_NUM_ARGS = 5,
+        ER_OUT_OF_RANGE   = 6,
+        ER_UART_INPUT     = 9,
+        ER_EXEC_FAILED    = 10,
+    };
+
+    uint8_t error() const { return get<f_error>(); }
+};
+
+#endif
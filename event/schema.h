@@ -0,0 +1,547 @@
+#ifndef _EVENT_SCHEMA_H_
+#define _EVENT_SCHEMA_H_
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "event_base.h"
+
+/*
+  compile-time schema of SKSTACK event lines.
+
+  an event line is its name followed by a list of fields. each field is a
+  (tag, type) pair: the tag names the field and carries the literal which
+  precedes it on the wire (" " for ordinary parameters, "\r\n  Label:" for
+  the EPANDESC style), the type decodes the value from fixed-width text.
+  CTypedEvent expands the field list into one straight-line parser per
+  event, and the values are reached through get<tag>() instead of names.
+ */
+
+#define SK_FIELD_TAG(tag_name, field_name, field_prefix)          \
+    struct tag_name {                                             \
+        static constexpr char name[] = field_name;                \
+        static constexpr char prefix[] = field_prefix;            \
+    }
+
+namespace sk_detail {
+
+constexpr uint8_t INVALID_DIGIT = 0xFF;
+
+constexpr std::array<uint8_t, 256> make_digit_table(int base)
+{
+    std::array<uint8_t, 256> table {};
+    for (int i = 0; i < 256; ++i) {
+        table[i] = INVALID_DIGIT;
+    }
+    for (int i = 0; i < 10; ++i) {
+        table['0' + i] = i;
+    }
+    if (base == 16) {
+        for (int i = 0; i < 6; ++i) {
+            table['A' + i] = 10 + i;
+            table['a' + i] = 10 + i;
+        }
+    }
+    return table;
+}
+
+inline constexpr std::array<uint8_t, 256> hex_table = make_digit_table(16);
+inline constexpr std::array<uint8_t, 256> dec_table = make_digit_table(10);
+
+template <int bits>
+struct uint_for {
+    using type = std::conditional_t<(bits <= 8), uint8_t,
+                 std::conditional_t<(bits <= 16), uint16_t,
+                 std::conditional_t<(bits <= 32), uint32_t, uint64_t>>>;
+};
+
+// match a literal. a partial match at the end of the buffer is EV_SHORT_LENGTH.
+template <long size>
+inline CEventMatchResult match(const char *&p, const char *end, const char (&literal)[size])
+{
+    constexpr long n = size - 1;
+    const long avail = end - p;
+    if (avail < n) {
+        if (avail <= 0) {
+            return EV_SHORT_LENGTH;
+        }
+        return std::memcmp(p, literal, (size_t)avail) == 0 ? EV_SHORT_LENGTH : EV_UNMATCHED;
+    }
+    if (std::memcmp(p, literal, n) != 0) {
+        return EV_UNMATCHED;
+    }
+    p += n;
+    return EV_MATCHED;
+}
+
+// decode a fixed number of digits. invalid digits are folded into one
+// flag so the loop has no early exits and unrolls for small widths.
+template <int digits, int base, class T>
+inline CEventMatchResult parse_digits(const char *&p, const char *end, T &out)
+{
+    const auto &table = base == 16 ? hex_table : dec_table;
+    const long avail = end - p;
+    const long n = avail < digits ? avail : digits;
+    uint64_t v = 0;
+    uint8_t bad = 0;
+    for (long i = 0; i < n; ++i) {
+        uint8_t d = table[(uint8_t)p[i]];
+        bad |= d;
+        v = v * base + (d & 0x0F);
+    }
+    if (bad & 0xF0) {
+        return EV_UNMATCHED;
+    }
+    if (n < digits) {
+        return EV_SHORT_LENGTH;
+    }
+    out = (T)v;
+    p += digits;
+    return EV_MATCHED;
+}
+
+// column of Tag's value from the end of the event name. every field
+// before it must have a fixed width
+template <class Tag, class F, class... Rest>
+constexpr long offset_of()
+{
+    if constexpr (std::is_same<Tag, typename F::tag>::value) {
+        return F::prefix_width;
+    } else {
+        return F::prefix_width + F::type::width + offset_of<Tag, Rest...>();
+    }
+}
+
+template <class Tag, class... Fields>
+struct index_of;
+
+template <class Tag>
+struct index_of<Tag> : std::integral_constant<size_t, 0> {};
+
+template <class Tag, class F, class... Rest>
+struct index_of<Tag, F, Rest...>
+    : std::integral_constant<size_t, std::is_same<Tag, typename F::tag>::value ? 0 : 1 + index_of<Tag, Rest...>::value> {};
+
+} // namespace sk_detail
+
+/*
+  field types
+ */
+
+template <int digits>
+struct sk_hex
+{
+    using value_type = typename sk_detail::uint_for<digits * 4>::type;
+    static constexpr long width = digits;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        return sk_detail::parse_digits<digits, 16>(p, end, out);
+    }
+};
+
+template <int digits>
+struct sk_dec
+{
+    using value_type = typename sk_detail::uint_for<(digits <= 2) ? 8 : (digits <= 4) ? 16 : (digits <= 9) ? 32 : 64>::type;
+    static constexpr long width = digits;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        return sk_detail::parse_digits<digits, 10>(p, end, out);
+    }
+};
+
+// 64bit link-layer address (16 hex digits)
+using sk_mac = sk_hex<16>;
+
+// "0" / "1"
+struct sk_flag
+{
+    using value_type = bool;
+    static constexpr long width = 1;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        uint8_t v = 0;
+        auto result = sk_detail::parse_digits<1, 16>(p, end, v);
+        out = v != 0;
+        return result;
+    }
+};
+
+// one hex digit ending the token: "0" matches, "00" does not
+struct sk_digit
+{
+    using value_type = uint8_t;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        const char *q = p;
+        auto result = sk_detail::parse_digits<1, 16>(q, end, out);
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        if (q == end) {
+            return EV_SHORT_LENGTH;
+        }
+        if ((sk_detail::hex_table[(uint8_t)*q] & 0xF0) == 0) {
+            return EV_UNMATCHED;
+        }
+        p = q;
+        return EV_MATCHED;
+    }
+};
+
+// SKSTACK always prints addresses unabbreviated: "FE80:0000:...:C890"
+struct sk_ipv6
+{
+    using value_type = std::array<uint8_t, 16>;
+    static constexpr long width = 39;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        const long avail = end - p;
+        if (avail < width) {
+            for (long i = 0; i < avail; ++i) {
+                bool ok = (i % 5 == 4) ? p[i] == ':' : sk_detail::hex_table[(uint8_t)p[i]] != sk_detail::INVALID_DIGIT;
+                if (!ok) {
+                    return EV_UNMATCHED;
+                }
+            }
+            return EV_SHORT_LENGTH;
+        }
+
+        uint8_t bad = 0;
+        for (int g = 0; g < 8; ++g) {
+            const char *q = p + g * 5;
+            uint8_t d0 = sk_detail::hex_table[(uint8_t)q[0]];
+            uint8_t d1 = sk_detail::hex_table[(uint8_t)q[1]];
+            uint8_t d2 = sk_detail::hex_table[(uint8_t)q[2]];
+            uint8_t d3 = sk_detail::hex_table[(uint8_t)q[3]];
+            bad |= d0 | d1 | d2 | d3;
+            if (g < 7) {
+                bad |= (q[4] != ':') << 4;
+            }
+            out[g * 2] = (uint8_t)((d0 << 4) | (d1 & 0x0F));
+            out[g * 2 + 1] = (uint8_t)((d2 << 4) | (d3 & 0x0F));
+        }
+        if (bad & 0xF0) {
+            return EV_UNMATCHED;
+        }
+        p += width;
+        return EV_MATCHED;
+    }
+};
+
+// WOPT selects how SKSTACK prints received data
+enum CPayloadEncoding {
+    PAYLOAD_BINARY,
+    PAYLOAD_ASCII_HEX,
+};
+
+// "<DATALEN> <DATA>": DATALEN is 4 hex digits counting decoded bytes
+template <CPayloadEncoding encoding = PAYLOAD_ASCII_HEX>
+struct sk_payload
+{
+    using value_type = std::vector<uint8_t>;
+    static constexpr long header_width = sk_hex<4>::width + 1;     // "<DATALEN> "
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        const char *q = p;
+        uint16_t length = 0;
+        auto result = sk_hex<4>::parse(q, end, length);
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        result = sk_detail::match(q, end, " ");
+        if (result != EV_MATCHED) {
+            return result;
+        }
+
+        const long avail = end - q;
+        if (encoding == PAYLOAD_BINARY) {
+            if (avail < length) {
+                return EV_SHORT_LENGTH;
+            }
+            out.assign((const uint8_t *)q, (const uint8_t *)q + length);
+            p = q + length;
+            return EV_MATCHED;
+        }
+
+        const long width = (long)length * 2;
+        const long n = avail < width ? avail : width;
+        uint8_t bad = 0;
+        for (long i = 0; i < n; ++i) {
+            bad |= sk_detail::hex_table[(uint8_t)q[i]];
+        }
+        if (bad & 0xF0) {
+            return EV_UNMATCHED;
+        }
+        if (n < width) {
+            return EV_SHORT_LENGTH;
+        }
+        out.resize(length);
+        for (long i = 0; i < length; ++i) {
+            uint8_t hi = sk_detail::hex_table[(uint8_t)q[i * 2]];
+            uint8_t lo = sk_detail::hex_table[(uint8_t)q[i * 2 + 1]];
+            out[i] = (uint8_t)((hi << 4) | lo);
+        }
+        p = q + width;
+        return EV_MATCHED;
+    }
+};
+
+// "<A> <B>"
+template <class A, class B>
+struct sk_pair
+{
+    using value_type = std::pair<typename A::value_type, typename B::value_type>;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        const char *q = p;
+        auto result = A::parse(q, end, out.first);
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        result = sk_detail::match(q, end, " ");
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        result = B::parse(q, end, out.second);
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        p = q;
+        return EV_MATCHED;
+    }
+};
+
+/*
+  fields
+ */
+
+template <class Tag, class Type>
+struct sk_field
+{
+    using tag = Tag;
+    using type = Type;
+    using value_type = typename Type::value_type;
+    static constexpr long prefix_width = sizeof(Tag::prefix) - 1;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        const char *q = p;
+        auto result = sk_detail::match(q, end, Tag::prefix);
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        result = Type::parse(q, end, out);
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        p = q;
+        return EV_MATCHED;
+    }
+};
+
+// a trailing field which some firmware versions omit
+template <class Tag, class Type>
+struct sk_optional_field
+{
+    using tag = Tag;
+    using value_type = std::optional<typename Type::value_type>;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        const char *q = p;
+        auto result = sk_detail::match(q, end, Tag::prefix);
+        if (result == EV_UNMATCHED) {
+            out.reset();
+            return EV_MATCHED;
+        } else if (result != EV_MATCHED) {
+            return result;
+        }
+        typename Type::value_type value {};
+        result = Type::parse(q, end, value);
+        if (result == EV_UNMATCHED) {
+            // the separator belongs to a later field
+            out.reset();
+            return EV_MATCHED;
+        } else if (result != EV_MATCHED) {
+            return result;
+        }
+        out = value;
+        p = q;
+        return EV_MATCHED;
+    }
+};
+
+// a field repeated until the next line does not parse as one
+template <class Tag, class Type>
+struct sk_list_field
+{
+    using tag = Tag;
+    using value_type = std::vector<typename Type::value_type>;
+
+    static CEventMatchResult parse(const char *&p, const char *end, value_type &out)
+    {
+        out.clear();
+        typename Type::value_type element {};
+        while (true) {
+            const char *q = p;
+            auto result = sk_detail::match(q, end, Tag::prefix);
+            if (result == EV_UNMATCHED) {
+                break;
+            } else if (result != EV_MATCHED) {
+                return result;
+            }
+            result = Type::parse(q, end, element);
+            if (result == EV_UNMATCHED) {
+                break;
+            } else if (result != EV_MATCHED) {
+                return result;
+            }
+            out.push_back(element);
+            p = q;
+        }
+        return EV_MATCHED;
+    }
+};
+
+/*
+  event
+ */
+
+template <class Derived, CEventType event_type, class... Fields>
+class CTypedEvent : public CEventBase
+{
+public:
+    using values_type = std::tuple<typename Fields::value_type...>;
+
+    static const char *get_event_name()
+    {
+        return Derived::event_name;
+    }
+
+    static const char *get_magic_number()
+    {
+        return Derived::event_name;
+    }
+
+    static long get_magic_number_size()
+    {
+        return sizeof(Derived::event_name) - 1;
+    }
+
+    static CEventType get_event_type()
+    {
+        return event_type;
+    }
+
+    CEventType get_type() const override
+    {
+        return event_type;
+    }
+
+    const char *get_name() const override
+    {
+        return Derived::event_name;
+    }
+
+    // column where the value of Tag starts in the raw line
+    template <class Tag>
+    static constexpr long offset_of()
+    {
+        return sizeof(Derived::event_name) - 1 + sk_detail::offset_of<Tag, Fields...>();
+    }
+
+    template <class Tag>
+    const auto &get() const
+    {
+        return std::get<sk_detail::index_of<Tag, Fields...>::value>(_values);
+    }
+
+    CEventMatchResult parse(const std::vector<char> &buf, long start, long length, long &next_pos) override
+    {
+        if (!valid_buffer_params(buf, start, length)) {
+            return EV_ERROR;
+        }
+        const char *p = buf.data() + start;
+        const char *end = p + length;
+
+        auto result = sk_detail::match(p, end, Derived::event_name);
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        result = parse_fields(p, end, std::index_sequence_for<Fields...>());
+        if (result != EV_MATCHED) {
+            return result;
+        }
+        result = sk_detail::match(p, end, "\r\n");
+        if (result != EV_MATCHED) {
+            return result;
+        }
+
+        next_pos = p - buf.data();
+        return EV_MATCHED;
+    }
+
+    // f(const char *name, const value_type &value) for every field in order
+    template <class F>
+    void for_each_field(F &&f) const
+    {
+        for_each_field(f, std::index_sequence_for<Fields...>());
+    }
+
+    bool serialize(COutputBuffer &out, CSerialFormat format) const override
+    {
+        switch (format) {
+        case FORMAT_JSON:
+            return write<CJsonFormat>(out);
+        case FORMAT_CSV:
+            return write<CCsvFormat>(out);
+        case FORMAT_BINARY:
+            return write<CBinaryFormat>(out);
+        }
+        return false;
+    }
+
+    template <class Format>
+    bool write(COutputBuffer &out) const
+    {
+        size_t mark = Format::begin(out, event_type, Derived::event_name);
+        for_each_field([&out](const char *name, const auto &value) {
+            Format::field(out, name);
+            Format::value(out, value);
+        });
+        return Format::end(out, mark);
+    }
+
+private:
+    values_type _values;
+
+    template <size_t... I>
+    CEventMatchResult parse_fields(const char *&p, const char *end, std::index_sequence<I...>)
+    {
+        CEventMatchResult result = EV_MATCHED;
+        (void)end;
+        (void)(((result = Fields::parse(p, end, std::get<I>(_values))) == EV_MATCHED) && ...);
+        return result;
+    }
+
+    template <class F, size_t... I>
+    void for_each_field(F &f, std::index_sequence<I...>) const
+    {
+        (f(Fields::tag::name, std::get<I>(_values)), ...);
+    }
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef _EVENT_SKEVENTS_H_
+#define _EVENT_SKEVENTS_H_
+
+#include "dispatcher.h"
+#include "erxudp.h"
+#include "erxtcp.h"
+#include "event.h"
+#include "epandesc.h"
+#include "eaddr.h"
+#include "eneighbor.h"
+#include "response.h"
+
+using CSkEventDispatcher = CEventDispatcher<
+    CEvERXUDP,
+    CEvERXTCP,
+    CEvEVENT,
+    CEvEPANDESC,
+    CEvEADDR,
+    CEvENEIGHBOR,
+    CEvOK,
+    CEvFAIL>;
+
+#endif
@@ -1,15 +1,103 @@
 #include <unistd.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <memory>
 #include "serial/serial.h"
 #include "serial/timeout.h"
-#include "event/erxudp.h"
+#include "event/skevents.h"
+#include "shm/shm_records.h"
+#include "command/command.h"
+#include "echonet/requester.h"
+#include "echonet/reading.h"
+#include "echonet/backfill.h"
+#include "echonet/discovery.h"
+#include "storage/interval_store.h"
+#include "scheduler/poll_scheduler.h"
+#include "reactor/reactor.h"
+#include "session/sk_session.h"
+#include "session/join.h"
+#include "session/health.h"
+
+struct CApp
+{
+    CReactor &reactor;
+    COutputBuffer &output;
+    CSkSession &session;
+    CPollScheduler &scheduler;
+    CEchonetRequester &requester;
+    CNodeDiscovery &discovery;
+    CHealthMonitor &health;
+    CIntervalStore *store;
+    std::unique_ptr<CBackfillJob> backfill;
+};
+
+// polled values are written out next to the events, as READING lines
+static CPollSpec::callback_type print_readings(COutputBuffer &output, const node_addr_t &node, const CEoj &eoj)
+{
+    return [&output, node, eoj](uint8_t epc, CRequestStatus status, const uint8_t *edt, uint8_t pdc) {
+        if (status != REQ_OK) {
+            return;
+        }
+        timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+
+        CReading reading;
+        reading.time = (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+        reading.node = node;
+        reading.eoj = eoj;
+        reading.epc = epc;
+        reading.edt.assign(edt, edt + pdc);
+        reading.decode();
+
+        output.clear();
+        reading.serialize(output, FORMAT_JSON);
+        output.append('\n');
+        fwrite(output.data(), 1, output.size(), stdout);
+    };
+}
+
+static CTask<int> run_meter(CApp &app, CJoinConfig config)
+{
+    CJoinResult joined = co_await sk_join(app.session, config);
+    if (joined.status != JOIN_OK) {
+        printf("join failed(%d)\n", joined.status);
+        app.reactor.stop();
+        co_return joined.status;
+    }
+
+    const CReactor::msec_t now = CReactor::now();
+    app.health.start(now, joined);
+    app.discovery.start();
+
+    auto on_reading = print_readings(app.output, joined.meter, EOJ_SMART_METER);
+    app.scheduler.add({ joined.meter, EOJ_SMART_METER, { EPC_INSTANT_POWER },
+                        POLL_INSTANT, 10 * 1000, 60 * 1000, on_reading }, now);
+
+    // EA/EB are E0/E3 as of the last 30 minute boundary: they go into the
+    // store too, so a later backfill only asks for slots nobody polled
+    CIntervalStore *store = app.store;
+    auto on_cumulative = [on_reading, store](uint8_t epc, CRequestStatus status, const uint8_t *edt, uint8_t pdc) {
+        on_reading(epc, status, edt, pdc);
+        if (store != nullptr && status == REQ_OK) {
+            store_fixed_time_reading(*store, epc, edt, pdc);
+        }
+    };
+    app.scheduler.add({ joined.meter, EOJ_SMART_METER,
+                        { EPC_CUMULATIVE_NORMAL, EPC_CUMULATIVE_REVERSE, EPC_FIXED_TIME_NORMAL, EPC_FIXED_TIME_REVERSE },
+                        POLL_CUMULATIVE, 60 * 1000, 30 * 60 * 1000, on_cumulative }, now);
+
+    if (app.store) {
+        const int64_t today = time(nullptr);
+        app.backfill.reset(new CBackfillJob(app.requester, *app.store, joined.meter));
+        app.backfill->plan(today - 7 * 24 * 60 * 60, today, today);
+    }
+    co_return 0;
+}
 
 int main(int argc, char *argv[])
 {
 #if 1
-    CEvERXUDP ev;
-    CEventParser<CEvERXUDP> parser;
-    
     CSerial serial;
     const char *port = "/dev/ttyUSB0";
     const speed_t rate = B115200;
@@ -20,41 +108,157 @@ int main(int argc, char *argv[])
         return ret;
     }
 
-    serial.set_timeout(2000);
-
-    char cmd[8] = {'S', 'K', 'V', 'E', 'R', '\r', '\n', 0};
-    serial.write(cmd, sizeof(cmd));
-
-    std::vector<char> buf(4096);
-
-    constexpr int count = 3;
-    for(int j=0; j < count; ++j) {
-        long len = serial.read(buf);
-        if (0 < len) {
-#if 0
-            printf("[len=%ld]\n", len);
-            for (int i=0; i < len; ++i) {
-                if (0x20 <= buf[i] && buf[i] <= 0x7e)
-                    printf("%c ", buf[i]);
-                else if (0x0d == buf[i])
-                    printf("\\r");
-                else if (0x0a == buf[i])
-                    printf("\\n");
-                else
-                    printf("? ");
+    CReactor reactor;
+    CSkSession session(reactor, serial);
+    ret = session.attach();
+    if (ret < 0) {
+        printf("attach failed(%d)\n", ret);
+        return ret;
+    }
+
+    CShmPublisher publisher;
+    const char *shm_socket = "/tmp/raspi-echonet.sock";
+    ret = publisher.create("raspi-echonet");
+    if (ret == 0) {
+        ret = publisher.listen(shm_socket);
+    }
+    if (ret == 0) {
+        reactor.add_fd(publisher.get_listen_fd(), EPOLLIN, [&](uint32_t) {
+            publisher.serve();
+        });
+    } else {
+        printf("shm publisher failed(%d)\n", ret);
+    }
+
+    std::vector<char> command;
+    CPropertyCache cache;
+    CTxBudget budget;
+    CPollScheduler *poller = nullptr;
+    CHealthMonitor *monitor = nullptr;
+    CEchonetRequester requester(cache, [&](const node_addr_t &node, const std::vector<uint8_t> &frame) {
+        auto airtime = CTxBudget::estimate_airtime(frame.size());
+        auto now = CReactor::now();
+        if (!budget.can_send(airtime, now)) {
+            return SEND_DEFERRED;
+        }
+        CSkCommand::sendto(command, 1, node, ECHONET_PORT, CSkCommand::SEC_ENCRYPT, frame);
+        session.submit(command, CSkSession::DEFAULT_TIMEOUT, [&](const CCommandResult &result) {
+            monitor->note_send(result);
+            // a bare ER10 is a failed send, only EVENT 32 says the limit is reached
+            if (result.status == CMD_OK) {
+                budget.clear_penalty();
+                poller->on_sent(CReactor::now());
             }
-            printf("\n");
-            for (int i=0; i < len; ++i) {
-                printf("%02X", buf[i]);
+        });
+        budget.record(airtime, now);
+        return SEND_OK;
+    });
+    CPollScheduler scheduler(requester, budget);
+    poller = &scheduler;
+
+    CJoinConfig config;
+    const char *id = getenv("RASPI_ECHONET_RBID");
+    const char *password = getenv("RASPI_ECHONET_PASSWORD");
+    config.route_b_id = id != nullptr ? id : "";
+    config.password = password != nullptr ? password : "";
+
+    CHealthMonitor health(reactor, session, serial, requester, config);
+    monitor = &health;
+    session.set_error_handler([&](int error) {
+        health.on_port_error(error);
+    });
+    health.set_report_handler([](const CRecoveryReport &report) {
+        printf("{\"event\":\"RECOVERED\",\"reason\":%d,\"level\":%d,\"attempts\":%d,\"msec\":%lld,\"error\":%d}\n",
+               report.reason, report.level, report.attempts, report.duration, report.error);
+    });
+
+    CNodeIndex index;
+    CNodeDiscovery discovery(requester, index);
+    requester.set_index(&index);
+    requester.set_frame_observer([&](const node_addr_t &sender, const CEchonetFrame &frame, CReactor::msec_t now) {
+        discovery.observe(sender, frame, now);
+    });
+
+    // only ECHONET Lite datagrams to our port, PANA (716) and MLE (19788) are dropped unparsed
+    CEventFilter filter;
+    CSubscription echonet;
+    echonet.types = CSubscription::type_bit(EVT_ERXUDP);
+    echonet.lport = ECHONET_PORT;
+    filter.subscribe(echonet);
+    session.set_filter(&filter);
+
+    COutputBuffer output;
+    session.set_event_handler([&](const CEventBase &ev) {
+        output.clear();
+        ev.serialize(output, FORMAT_JSON);
+        output.append('\n');
+        fwrite(output.data(), 1, output.size(), stdout);
+        shm_publish(publisher, ev);
+        health.note_event(ev);
+        switch (ev.get_type()) {
+        case EVT_ERXUDP: {
+            const auto &rx = static_cast<const CEvERXUDP &>(ev);
+            if (rx.rport() == ECHONET_PORT && requester.handle(rx.sender(), rx.data(), CReactor::now())) {
+                health.note_response(CReactor::now());
             }
-            printf("\n");
-#endif
-        } else if (len == 0) {
-            char cmd2[11] = {'S', 'K', 'A', 'P', 'P', 'V', 'E', 'R', '\r', '\n', 0};
-            serial.write(cmd2, sizeof(cmd2));
+            break;
+        }
+        case EVT_EVENT:
+            if (static_cast<const CEvEVENT &>(ev).num() == CEvEVENT::TX_LIMIT_REACHED) {
+                scheduler.on_tx_limit(CReactor::now());
+            }
+            break;
+        default:
+            break;
+        }
+    });
+
+    CFileIntervalStore file_store;
+    const char *store_path = getenv("RASPI_ECHONET_STORE");
+    // the events have their own buffer, readings are printed from inside the event handler
+    COutputBuffer reading_output;
+    CApp app { reactor, reading_output, session, scheduler, requester, discovery, health, nullptr, nullptr };
+    if (store_path != nullptr) {
+        ret = file_store.open(store_path);
+        if (ret < 0) {
+            printf("store open failed(%d)\n", ret);
+        } else {
+            app.store = &file_store;
         }
     }
-                     
+
+    const CReactor::msec_t tick = 1000;
+    std::function<void()> on_tick = [&]() {
+        const CReactor::msec_t now = CReactor::now();
+        health.check(now);
+        discovery.run(now);
+        scheduler.run(now);
+        if (app.backfill && !app.backfill->run(now)) {
+            printf("backfill done: %zu inserted, %zu failed\n", app.backfill->inserted(), app.backfill->failed());
+            app.backfill.reset();
+        }
+        requester.flush(now);
+        requester.expire(now);
+        reactor.add_timer(tick, on_tick);
+    };
+    reactor.add_timer(tick, on_tick);
+
+    CTask<int> meter = run_meter(app, config);
+    meter.start();
+    reactor.run();
+    session.detach();
+
+    const CFilterStats &stats = filter.get_stats();
+    printf("events passed %llu, dropped type %llu header %llu payload %llu\n",
+           (unsigned long long)stats.passed, (unsigned long long)stats.dropped[FILTER_TYPE],
+           (unsigned long long)stats.dropped[FILTER_HEADER], (unsigned long long)stats.dropped[FILTER_PAYLOAD]);
+
+    printf("discarded %llu bytes of overlong lines\n", session.discarded());
+
+    const CHealthStats &health_stats = health.get_stats();
+    printf("stalls %u, downtime %lld msec, longest recovery %lld msec\n",
+           health_stats.stalls, health_stats.total_downtime, health_stats.max_recovery);
+
 #else
     CTimeout t(3000);
     while (!t.is_expired()) {
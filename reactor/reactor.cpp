@@ -0,0 +1,152 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "reactor.h"
+#include "../serial/timeout.h"
+
+CReactor::CReactor()
+    : _stopped(false), _next_timer(1)
+{
+    _epfd = epoll_create1(EPOLL_CLOEXEC);
+#ifdef DEBUG_REACTOR
+    if (_epfd < 0) {
+        fprintf(stderr, "[DEBUG] CReactor::CReactor(): epoll_create1 failed\n"
+                        "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+    }
+#endif
+}
+
+CReactor::~CReactor()
+{
+    if (_epfd >= 0) {
+        close(_epfd);
+    }
+}
+
+CReactor::msec_t CReactor::now()
+{
+    return monotonic_msec();
+}
+
+int CReactor::add_fd(int fd, uint32_t events, fd_callback_type callback)
+{
+    if (_epfd < 0) {
+        return E_REACTOR_NOT_OPENED;
+    }
+    if (fd < 0 || !callback) {
+        return E_REACTOR_INVALID_ARG;
+    }
+
+    epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.fd = fd;
+    int op = _fds.count(fd) != 0 ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    if (epoll_ctl(_epfd, op, fd, &ev) < 0) {
+#ifdef DEBUG_REACTOR
+        fprintf(stderr, "[DEBUG] CReactor::add_fd(%d, ...): E_REACTOR_EPOLL_FAILED\n"
+                        "        errno=%d, msg=\"%s\"\n", fd, errno, strerror(errno));
+#endif
+        return E_REACTOR_EPOLL_FAILED;
+    }
+    _fds[fd] = std::move(callback);
+    return 0;
+}
+
+void CReactor::remove_fd(int fd)
+{
+    if (_fds.erase(fd) != 0 && _epfd >= 0) {
+        epoll_ctl(_epfd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+CReactor::timer_id CReactor::add_timer(msec_t delay_msec, timer_callback_type callback)
+{
+    return add_timer_at(now() + delay_msec, std::move(callback));
+}
+
+CReactor::timer_id CReactor::add_timer_at(msec_t when, timer_callback_type callback)
+{
+    timer_id id = _next_timer++;
+    _timers.emplace(std::make_pair(when, id), std::move(callback));
+    _timer_due.emplace(id, when);
+    return id;
+}
+
+void CReactor::cancel_timer(timer_id id)
+{
+    auto it = _timer_due.find(id);
+    if (it == _timer_due.end()) {
+        return;
+    }
+    _timers.erase(std::make_pair(it->second, id));
+    _timer_due.erase(it);
+}
+
+int CReactor::run_timers()
+{
+    int ran = 0;
+    const msec_t t = now();
+    while (!_timers.empty() && _timers.begin()->first.first <= t) {
+        auto it = _timers.begin();
+        timer_callback_type callback = std::move(it->second);
+        _timer_due.erase(it->first.second);
+        _timers.erase(it);
+        callback();
+        ++ran;
+    }
+    return ran;
+}
+
+int CReactor::run_once(msec_t max_wait_msec)
+{
+    if (_epfd < 0) {
+        return E_REACTOR_NOT_OPENED;
+    }
+
+    int ran = run_timers();
+
+    msec_t wait = max_wait_msec;
+    if (!_timers.empty()) {
+        msec_t until_timer = _timers.begin()->first.first - now();
+        if (until_timer < 0) {
+            until_timer = 0;
+        }
+        if (wait < 0 || until_timer < wait) {
+            wait = until_timer;
+        }
+    }
+    if (ran > 0) {
+        wait = 0;
+    }
+
+    epoll_event events[16];
+    int n = epoll_wait(_epfd, events, 16, (int)wait);
+    if (n < 0 && errno != EINTR) {
+        return E_REACTOR_EPOLL_FAILED;
+    }
+    for (int i = 0; i < n; ++i) {
+        auto it = _fds.find(events[i].data.fd);
+        if (it == _fds.end()) {
+            // removed by an earlier callback
+            continue;
+        }
+        fd_callback_type callback = it->second;
+        callback(events[i].events);
+        ++ran;
+    }
+
+    return ran + run_timers();
+}
+
+void CReactor::run()
+{
+    _stopped = false;
+    while (!_stopped) {
+        if (run_once() < 0) {
+            break;
+        }
+    }
+}
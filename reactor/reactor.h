@@ -0,0 +1,70 @@
+#ifndef _REACTOR_REACTOR_H_
+#define _REACTOR_REACTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <sys/epoll.h>
+
+enum CReactorError {
+    E_REACTOR_INVALID_ARG   = -1,
+    E_REACTOR_NOT_OPENED    = -2,
+    E_REACTOR_EPOLL_FAILED  = -10,
+};
+
+/*
+  single threaded event loop: epoll for descriptors, a sorted map for
+  timers on the monotonic clock. callbacks may add or remove descriptors
+  and timers, including their own.
+ */
+class CReactor
+{
+public:
+    using msec_t = long long;
+    using timer_id = uint64_t;
+    using fd_callback_type = std::function<void(uint32_t events)>;
+    using timer_callback_type = std::function<void()>;
+
+    CReactor();
+
+    ~CReactor();
+
+    int add_fd(int fd, uint32_t events, fd_callback_type callback);
+
+    void remove_fd(int fd);
+
+    timer_id add_timer(msec_t delay_msec, timer_callback_type callback);
+
+    timer_id add_timer_at(msec_t when, timer_callback_type callback);
+
+    // unknown or already fired ids are ignored
+    void cancel_timer(timer_id id);
+
+    // waits up to max_wait_msec (-1: until something happens), returns the callbacks run
+    int run_once(msec_t max_wait_msec = -1);
+
+    void run();
+
+    void stop()
+    {
+        _stopped = true;
+    }
+
+    static msec_t now();
+
+private:
+    int _epfd;
+    bool _stopped;
+
+    std::unordered_map<int, fd_callback_type> _fds;
+
+    timer_id _next_timer;
+    std::map<std::pair<msec_t, timer_id>, timer_callback_type> _timers;
+    std::unordered_map<timer_id, msec_t> _timer_due;
+
+    int run_timers();
+};
+
+#endif
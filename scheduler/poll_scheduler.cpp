@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <limits>
+
+#include "poll_scheduler.h"
+
+namespace {
+
+using msec_t = CPollScheduler::msec_t;
+
+// share of the budget each priority may fill
+const double BUDGET_SHARE[POLL_PRIORITY_COUNT] = { 1.0, 0.85, 0.7 };
+
+const double MAX_TARGET = 0.9;
+const double MIN_TARGET = 0.05;
+const double TARGET_STEP = 0.05;
+
+const msec_t RAISE_PERIOD = 60 * 1000;          // between two steps up
+const msec_t QUIET_PERIOD = 10 * 60 * 1000;     // without limits before growing the target
+const msec_t RETRY_DELAY = 5 * 1000;            // a poll refused by the budget
+
+// EHD(2) TID(2) SEOJ(3) DEOJ(3) ESV(1) OPC(1) + EPC PDC per property
+size_t get_frame_size(size_t epcs)
+{
+    return 12 + epcs * 2;
+}
+
+}
+
+CPollScheduler::CPollScheduler(CEchonetRequester &requester, CTxBudget &budget)
+    : _requester(requester), _budget(budget), _next_id(1), _target(MAX_TARGET), _last_limit(0), _last_raise(0)
+{
+}
+
+int CPollScheduler::add(const CPollSpec &spec, msec_t now)
+{
+    CPoll poll;
+    poll.id = _next_id++;
+    poll.spec = spec;
+    poll.spec.max_interval = std::max(spec.max_interval, spec.min_interval);
+    poll.interval = spec.min_interval;
+    poll.due = now;
+    poll.airtime = CTxBudget::estimate_airtime(get_frame_size(spec.epcs.size()));
+
+    auto it = std::upper_bound(_polls.begin(), _polls.end(), poll, [](const CPoll &a, const CPoll &b) {
+        return a.spec.priority < b.spec.priority;
+    });
+    _polls.insert(it, poll);
+
+    adapt(now);
+    return poll.id;
+}
+
+void CPollScheduler::remove(int id)
+{
+    _polls.erase(std::remove_if(_polls.begin(), _polls.end(), [id](const CPoll &p) { return p.id == id; }), _polls.end());
+}
+
+int CPollScheduler::run(msec_t now)
+{
+    int issued = 0;
+    CTxBudget::usec_t pending = 0;
+    for (auto &poll : _polls) {
+        if (poll.due > now) {
+            continue;
+        }
+        if (!_budget.can_send(pending + poll.airtime, now, BUDGET_SHARE[poll.spec.priority])) {
+            poll.due = now + std::min(poll.interval, RETRY_DELAY);
+            continue;
+        }
+        pending += poll.airtime;
+
+        auto callback = poll.spec.callback;
+        for (uint8_t epc : poll.spec.epcs) {
+            _requester.get(poll.spec.node, poll.spec.eoj, epc, [callback, epc](CRequestStatus status, const uint8_t *edt, uint8_t pdc) {
+                if (callback) {
+                    callback(epc, status, edt, pdc);
+                }
+            }, now);
+        }
+
+        // keep the phase unless we fell more than an interval behind
+        poll.due += poll.interval;
+        if (poll.due <= now) {
+            poll.due = now + poll.interval;
+        }
+        ++issued;
+    }
+    return issued;
+}
+
+void CPollScheduler::adapt(msec_t now)
+{
+    // airtime (usec) per msec the polls may use
+    const double rate = _budget.sustainable_rate() * _target;
+
+    double demand[POLL_PRIORITY_COUNT] = {};
+    double total = 0;
+    for (auto &poll : _polls) {
+        poll.interval = poll.spec.min_interval;
+        double d = (double)poll.airtime / poll.interval;
+        demand[poll.spec.priority] += d;
+        total += d;
+    }
+
+    // stretch the least important polls first
+    for (int priority = POLL_PRIORITY_COUNT - 1; priority >= 0 && total > rate; --priority) {
+        double excess = total - rate;
+        double target = std::max(demand[priority] - excess, 0.0);
+        double stretched = 0;
+        for (auto &poll : _polls) {
+            if (poll.spec.priority != priority) {
+                continue;
+            }
+            double scale = target > 0 ? demand[priority] / target : 1e9;
+            double interval = std::min((double)poll.interval * scale, (double)poll.spec.max_interval);
+            poll.interval = (msec_t)interval;
+            stretched += (double)poll.airtime / poll.interval;
+        }
+        total -= demand[priority] - stretched;
+        demand[priority] = stretched;
+    }
+
+    for (auto &poll : _polls) {
+        if (poll.due > now + poll.interval) {
+            poll.due = now + poll.interval;
+        }
+    }
+}
+
+void CPollScheduler::on_tx_limit(msec_t now)
+{
+    if (_budget.is_blocked(now)) {
+        // nothing was sent since the last report, this is the same refusal
+        return;
+    }
+    _last_limit = now;
+    _target = std::max(_target / 2, MIN_TARGET);
+    _budget.penalize(now);
+    adapt(now);
+
+    // give the next due polls the full penalty before trying again
+    for (auto &poll : _polls) {
+        poll.due = std::max(poll.due, now + poll.interval);
+    }
+}
+
+void CPollScheduler::on_sent(msec_t now)
+{
+    if (_target >= MAX_TARGET || now - _last_raise < RAISE_PERIOD
+        || (_last_limit != 0 && now - _last_limit < QUIET_PERIOD)) {
+        return;
+    }
+    _last_raise = now;
+    _target = std::min(_target + TARGET_STEP, MAX_TARGET);
+    adapt(now);
+}
+
+CPollScheduler::msec_t CPollScheduler::next_due() const
+{
+    msec_t due = std::numeric_limits<msec_t>::max();
+    for (const auto &poll : _polls) {
+        due = std::min(due, poll.due);
+    }
+    return due;
+}
+
+CPollScheduler::msec_t CPollScheduler::get_interval(int id) const
+{
+    for (const auto &poll : _polls) {
+        if (poll.id == id) {
+            return poll.interval;
+        }
+    }
+    return -1;
+}
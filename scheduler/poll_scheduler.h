@@ -0,0 +1,97 @@
+#ifndef _SCHEDULER_POLL_SCHEDULER_H_
+#define _SCHEDULER_POLL_SCHEDULER_H_
+
+#include <functional>
+#include <vector>
+
+#include "tx_budget.h"
+#include "../echonet/requester.h"
+
+enum CPollPriority {
+    POLL_INSTANT        = 0,    // instantaneous power / current
+    POLL_CUMULATIVE     = 1,    // cumulative energy
+    POLL_HISTORY        = 2,    // history, diagnostics
+    POLL_PRIORITY_COUNT,
+};
+
+struct CPollSpec
+{
+    using msec_t = CTxBudget::msec_t;
+    using callback_type = std::function<void(uint8_t epc, CRequestStatus status, const uint8_t *edt, uint8_t pdc)>;
+
+    node_addr_t node;
+    CEoj eoj;
+    std::vector<uint8_t> epcs;
+    CPollPriority priority;
+    msec_t min_interval;        // fastest rate wanted
+    msec_t max_interval;        // slowest rate acceptable
+    callback_type callback;
+};
+
+/*
+  periodic Gets within the transmit budget.
+
+  polls run most important first, and less important ones may only use a
+  smaller share of the budget so they are the first to wait. intervals
+  are recomputed from the rate the budget sustains: starting from every
+  poll's min_interval, the least important polls are stretched towards
+  their max_interval until the expected airtime fits. the usable part of
+  the budget is halved whenever the module reports the limit, once per
+  episode, and grows back slowly as sends keep going through.
+ */
+class CPollScheduler
+{
+public:
+    using msec_t = CTxBudget::msec_t;
+
+    CPollScheduler(CEchonetRequester &requester, CTxBudget &budget);
+
+    // returns the poll id
+    int add(const CPollSpec &spec, msec_t now);
+
+    void remove(int id);
+
+    // issues the polls which are due, returns how many were issued
+    int run(msec_t now);
+
+    // recomputes the intervals for the current target
+    void adapt(msec_t now);
+
+    // EVENT 32 (transmit limit reached). reports while the budget is held
+    // back are the same episode and ignored
+    void on_tx_limit(msec_t now);
+
+    // SKSENDTO went through, the only thing which raises the target again
+    void on_sent(msec_t now);
+
+    // earliest time run() has something to do
+    msec_t next_due() const;
+
+    msec_t get_interval(int id) const;
+
+    double get_target() const
+    {
+        return _target;
+    }
+
+private:
+    struct CPoll
+    {
+        int id;
+        CPollSpec spec;
+        msec_t interval;
+        msec_t due;
+        CTxBudget::usec_t airtime;
+    };
+
+    CEchonetRequester &_requester;
+    CTxBudget &_budget;
+
+    std::vector<CPoll> _polls;     // sorted by priority
+    int _next_id;
+    double _target;
+    msec_t _last_limit;
+    msec_t _last_raise;
+};
+
+#endif
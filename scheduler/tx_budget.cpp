@@ -0,0 +1,61 @@
+#include "tx_budget.h"
+
+namespace {
+
+// 920MHz GFSK at 100 kbps: 80 usec per octet
+const CTxBudget::usec_t USEC_PER_OCTET = 80;
+
+// SHR + PHR (12), MAC header with 64bit addresses (23), security
+// auxiliary header and MIC (14), compressed IPv6/UDP headers (10), FCS (4)
+const size_t FRAME_OVERHEAD = 63;
+
+// 6LoWPAN fragments beyond this
+const size_t FRAGMENT_PAYLOAD = 90;
+
+// CSMA-CA backoff and the odd retransmission
+const double CHANNEL_ACCESS_FACTOR = 1.25;
+
+const CTxBudget::msec_t MIN_PENALTY = 30 * 1000;
+const CTxBudget::msec_t MAX_PENALTY = 15 * 60 * 1000;
+
+}
+
+CTxBudget::usec_t CTxBudget::estimate_airtime(size_t payload_size)
+{
+    size_t frames = payload_size / FRAGMENT_PAYLOAD + 1;
+    size_t octets = payload_size + frames * FRAME_OVERHEAD;
+    return (usec_t)(octets * USEC_PER_OCTET * CHANNEL_ACCESS_FACTOR);
+}
+
+bool CTxBudget::can_send(usec_t airtime, msec_t now, double share)
+{
+    if (now < _blocked_until) {
+        return false;
+    }
+    roll(now);
+    return _used + airtime <= (usec_t)(_budget * share);
+}
+
+void CTxBudget::record(usec_t airtime, msec_t now)
+{
+    roll(now);
+    _sends.push_back(CSend { now, airtime });
+    _used += airtime;
+}
+
+void CTxBudget::penalize(msec_t now)
+{
+    _penalty = _penalty == 0 ? MIN_PENALTY : _penalty * 2;
+    if (_penalty > MAX_PENALTY) {
+        _penalty = MAX_PENALTY;
+    }
+    _blocked_until = now + _penalty;
+}
+
+void CTxBudget::roll(msec_t now)
+{
+    while (!_sends.empty() && _sends.front().time + _window <= now) {
+        _used -= _sends.front().airtime;
+        _sends.pop_front();
+    }
+}
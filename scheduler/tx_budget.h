@@ -0,0 +1,94 @@
+#ifndef _SCHEDULER_TX_BUDGET_H_
+#define _SCHEDULER_TX_BUDGET_H_
+
+#include <cstddef>
+#include <deque>
+
+/*
+  rolling transmit-time budget of the 920MHz radio.
+
+  ARIB STD-T108 limits the total transmit time of a station to 360 s in
+  any hour; SKSTACK answers FAIL ER10 / EVENT 32 once it is reached.
+  every SKSENDTO is charged an estimated airtime, and a send is allowed
+  only while the airtime of the last window stays within the budget.
+ */
+class CTxBudget
+{
+public:
+    using msec_t = long long;
+    using usec_t = long long;
+
+    CTxBudget(msec_t window_msec = 60 * 60 * 1000, usec_t budget_usec = 360LL * 1000 * 1000)
+        : _window(window_msec), _budget(budget_usec), _used(0), _blocked_until(0), _penalty(0)
+    {
+    }
+
+    // airtime of one SKSENDTO carrying payload_size bytes of UDP data
+    static usec_t estimate_airtime(size_t payload_size);
+
+    // fraction (0..1] of the budget the caller may use, lower for less important traffic
+    bool can_send(usec_t airtime, msec_t now, double share = 1.0);
+
+    void record(usec_t airtime, msec_t now);
+
+    // the module refused to send: stop sending for a while, longer each time
+    void penalize(msec_t now);
+
+    // still holding sends back after penalize()
+    bool is_blocked(msec_t now) const
+    {
+        return now < _blocked_until;
+    }
+
+    // a send went through after a penalty
+    void clear_penalty()
+    {
+        _penalty = 0;
+    }
+
+    usec_t used(msec_t now)
+    {
+        roll(now);
+        return _used;
+    }
+
+    double utilization(msec_t now)
+    {
+        return (double)used(now) / _budget;
+    }
+
+    // long term rate the budget allows, in usec of airtime per msec
+    double sustainable_rate() const
+    {
+        return (double)_budget / _window;
+    }
+
+    msec_t get_window() const
+    {
+        return _window;
+    }
+
+    usec_t get_budget() const
+    {
+        return _budget;
+    }
+
+private:
+    struct CSend
+    {
+        msec_t time;
+        usec_t airtime;
+    };
+
+    msec_t _window;
+    usec_t _budget;
+    usec_t _used;
+    std::deque<CSend> _sends;
+
+    msec_t _blocked_until;
+    msec_t _penalty;
+
+    void roll(msec_t now);
+};
+
+#endif
@@ -1,9 +1,13 @@
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/ioctl.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <limits.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <linux/usbdevice_fs.h>
 
 #include "serial.h"
 #include "timeout.h"
@@ -75,6 +79,8 @@ int CSerial::open(const char *name, speed_t brate)
     tcsetattr(fd, TCSANOW, &_newtio);
 
     _fd = fd;
+    _name = name;
+    _rate = brate;
     
 #ifdef DEBUG_SERIAL
     fprintf(stderr, "[DEBUG] CSerial::open(...): open succeeded. fd=%d\n", fd); 
@@ -82,6 +88,101 @@ int CSerial::open(const char *name, speed_t brate)
     return 0;
 }
 
+int CSerial::reopen()
+{
+#ifdef DEBUG_SERIAL
+    fprintf(stderr, "[DEBUG] CSerial::reopen(void)\n"); 
+#endif
+    if (_name.empty()) {
+#ifdef DEBUG_SERIAL
+        fprintf(stderr, "[DEBUG] CSerial::reopen(...): E_INVALID_ARG\n"); 
+#endif
+        return E_INVALID_ARG;
+    }
+    close();
+    std::string name = _name;
+    return open(name.c_str(), _rate);
+}
+
+static bool read_sysfs_int(const std::string &path, int &value)
+{
+    FILE *fp = fopen(path.c_str(), "r");
+    if (fp == nullptr) {
+        return false;
+    }
+    bool ok = fscanf(fp, "%d", &value) == 1;
+    fclose(fp);
+    return ok;
+}
+
+int CSerial::reset_usb()
+{
+#ifdef DEBUG_SERIAL
+    fprintf(stderr, "[DEBUG] CSerial::reset_usb(void)\n"); 
+#endif
+    if (_name.empty()) {
+#ifdef DEBUG_SERIAL
+        fprintf(stderr, "[DEBUG] CSerial::reset_usb(...): E_INVALID_ARG\n"); 
+#endif
+        return E_INVALID_ARG;
+    }
+
+    // /dev/ttyUSB0 -> /sys/class/tty/ttyUSB0/device, then up to the USB device
+    char real[PATH_MAX];
+    if (realpath(_name.c_str(), real) == nullptr) {
+#ifdef DEBUG_SERIAL
+        fprintf(stderr, "[DEBUG] CSerial::reset_usb(...): E_USB_NOT_FOUND (%s)\n", _name.c_str()); 
+#endif
+        return E_USB_NOT_FOUND;
+    }
+    std::string sys = std::string("/sys/class/tty/") + (strrchr(real, '/') + 1) + "/device";
+    if (realpath(sys.c_str(), real) == nullptr) {
+#ifdef DEBUG_SERIAL
+        fprintf(stderr, "[DEBUG] CSerial::reset_usb(...): E_USB_NOT_FOUND (%s)\n", sys.c_str()); 
+#endif
+        return E_USB_NOT_FOUND;
+    }
+
+    std::string dir = real;
+    int busnum = -1, devnum = -1;
+    while (!(read_sysfs_int(dir + "/busnum", busnum) && read_sysfs_int(dir + "/devnum", devnum))) {
+        size_t slash = dir.rfind('/');
+        if (slash == 0 || slash == std::string::npos) {
+#ifdef DEBUG_SERIAL
+            fprintf(stderr, "[DEBUG] CSerial::reset_usb(...): E_USB_NOT_FOUND (not a USB device)\n"); 
+#endif
+            return E_USB_NOT_FOUND;
+        }
+        dir.erase(slash);
+    }
+
+    char usb[64];
+    snprintf(usb, sizeof(usb), "/dev/bus/usb/%03d/%03d", busnum, devnum);
+    int fd = ::open(usb, O_WRONLY);
+    if (fd < 0) {
+#ifdef DEBUG_SERIAL
+        fprintf(stderr, "[DEBUG] CSerial::reset_usb(...): E_USB_RESET_FAILED\n"
+                        "        path=%s, errno=%d, msg=\"%s\"\n",
+                usb, errno, strerror(errno)); 
+#endif
+        return E_USB_RESET_FAILED;
+    }
+    int ret = ioctl(fd, USBDEVFS_RESET, 0);
+    ::close(fd);
+    if (ret < 0) {
+#ifdef DEBUG_SERIAL
+        fprintf(stderr, "[DEBUG] CSerial::reset_usb(...): E_USB_RESET_FAILED\n"
+                        "        ret=%d, errno=%d, msg=\"%s\"\n",
+                ret, errno, strerror(errno)); 
+#endif
+        return E_USB_RESET_FAILED;
+    }
+#ifdef DEBUG_SERIAL
+    fprintf(stderr, "[DEBUG] CSerial::reset_usb(...): reset %s\n", usb); 
+#endif
+    return 0;
+}
+
 void CSerial::close()
 {
 #ifdef DEBUG_SERIAL
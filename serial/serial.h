@@ -2,6 +2,7 @@
 #define _SERIAL_H_
 
 #include <termios.h>
+#include <string>
 #include <vector>
 
 enum CSerialError {
@@ -11,6 +12,8 @@ enum CSerialError {
     E_READ_FAILED   = -11,
     E_WRITE_FAILED  = -12,
     E_SELECT_FAILED = -13,
+    E_USB_NOT_FOUND = -14,
+    E_USB_RESET_FAILED = -15,
 };
 
 class CSerial 
@@ -21,7 +24,7 @@ public:
     const timeout_t INFINITE = -1;
   
     CSerial()
-        : _timeout_msec(INFINITE), _fd(CLOSED)
+        : _timeout_msec(INFINITE), _fd(CLOSED), _rate(B0)
     {
     }
 
@@ -31,6 +34,13 @@ public:
 
     void close();
 
+    // closes and opens the port given to the last successful open()
+    int reopen();
+
+    // USBDEVFS_RESET on the USB device behind the port. the tty goes away
+    // and comes back, so close() first and reopen() after it has settled
+    int reset_usb();
+
     long read(std::vector<char> &buf, long start = 0, long read_size = 1);
     
     size_t write(const void *buf, size_t count);
@@ -47,12 +57,19 @@ public:
     {
         return _fd >= 0;
     }
+    int get_fd()
+    {
+        return _fd;
+    }
     
 private:
     long _timeout_msec;
     
     int _fd;
     struct termios _oldtio, _newtio;
+
+    std::string _name;
+    speed_t _rate;
 };
 
 #endif
@@ -3,6 +3,14 @@
 
 #include <time.h>
 
+// for measuring intervals; unaffected by clock adjustments
+inline long long monotonic_msec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
 class CTimeout
 {
 public:
@@ -0,0 +1,252 @@
+#ifndef _SERIALIZE_FORMATS_H_
+#define _SERIALIZE_FORMATS_H_
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "output_buffer.h"
+
+enum CSerialFormat {
+    FORMAT_JSON,        // one object per line
+    FORMAT_CSV,         // kind first, then the fields in schema order
+    FORMAT_BINARY,      // u16 length, u8 kind, fields little endian
+};
+
+/*
+  a format writes a record as
+      mark = begin(out, kind, name); { field(out, name); value(out, v); }... end(out, mark);
+  and has a value() overload for every field value type of the schema.
+  end() returns false if the format cannot hold the record; it is then
+  removed from out again.
+ */
+
+inline void append_ipv6(COutputBuffer &out, const std::array<uint8_t, 16> &addr)
+{
+    for (int i = 0; i < 16; i += 2) {
+        if (i != 0) {
+            out.append(':');
+        }
+        out.append_hex(&addr[i], 2);
+    }
+}
+
+struct CJsonFormat
+{
+    static size_t begin(COutputBuffer &out, uint8_t kind, const char *name)
+    {
+        out.append("{\"event\":\"");
+        out.append_str(name);
+        out.append('"');
+        return out.size();
+    }
+
+    static void field(COutputBuffer &out, const char *name)
+    {
+        out.append(",\"");
+        out.append_str(name);
+        out.append("\":");
+    }
+
+    static bool end(COutputBuffer &out, size_t mark)
+    {
+        out.append('}');
+        return true;
+    }
+
+    static void value(COutputBuffer &out, bool v)
+    {
+        if (v) {
+            out.append("true");
+        } else {
+            out.append("false");
+        }
+    }
+
+    static void value(COutputBuffer &out, uint8_t v) { out.append_uint(v); }
+    static void value(COutputBuffer &out, uint16_t v) { out.append_uint(v); }
+    static void value(COutputBuffer &out, uint32_t v) { out.append_uint(v); }
+    static void value(COutputBuffer &out, int64_t v) { out.append_int(v); }
+
+    // does not fit a JSON number exactly
+    static void value(COutputBuffer &out, uint64_t v)
+    {
+        out.append('"');
+        out.append_hex(v, 16);
+        out.append('"');
+    }
+
+    static void value(COutputBuffer &out, const std::array<uint8_t, 16> &v)
+    {
+        out.append('"');
+        append_ipv6(out, v);
+        out.append('"');
+    }
+
+    static void value(COutputBuffer &out, const std::vector<uint8_t> &v)
+    {
+        out.append('"');
+        out.append_hex(v.data(), v.size());
+        out.append('"');
+    }
+
+    template <class T>
+    static void value(COutputBuffer &out, const std::optional<T> &v)
+    {
+        if (v) {
+            value(out, *v);
+        } else {
+            out.append("null");
+        }
+    }
+
+    template <class A, class B>
+    static void value(COutputBuffer &out, const std::pair<A, B> &v)
+    {
+        out.append('[');
+        value(out, v.first);
+        out.append(',');
+        value(out, v.second);
+        out.append(']');
+    }
+
+    template <class T>
+    static void value(COutputBuffer &out, const std::vector<T> &v)
+    {
+        out.append('[');
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (i != 0) {
+                out.append(',');
+            }
+            value(out, v[i]);
+        }
+        out.append(']');
+    }
+};
+
+struct CCsvFormat
+{
+    static size_t begin(COutputBuffer &out, uint8_t kind, const char *name)
+    {
+        out.append_str(name);
+        return out.size();
+    }
+
+    static void field(COutputBuffer &out, const char *name)
+    {
+        out.append(',');
+    }
+
+    static bool end(COutputBuffer &out, size_t mark)
+    {
+        return true;
+    }
+
+    static void value(COutputBuffer &out, bool v) { out.append(v ? '1' : '0'); }
+    static void value(COutputBuffer &out, uint8_t v) { out.append_uint(v); }
+    static void value(COutputBuffer &out, uint16_t v) { out.append_uint(v); }
+    static void value(COutputBuffer &out, uint32_t v) { out.append_uint(v); }
+    static void value(COutputBuffer &out, int64_t v) { out.append_int(v); }
+    static void value(COutputBuffer &out, uint64_t v) { out.append_hex(v, 16); }
+    static void value(COutputBuffer &out, const std::array<uint8_t, 16> &v) { append_ipv6(out, v); }
+    static void value(COutputBuffer &out, const std::vector<uint8_t> &v) { out.append_hex(v.data(), v.size()); }
+
+    template <class T>
+    static void value(COutputBuffer &out, const std::optional<T> &v)
+    {
+        if (v) {
+            value(out, *v);
+        }
+    }
+
+    template <class A, class B>
+    static void value(COutputBuffer &out, const std::pair<A, B> &v)
+    {
+        value(out, v.first);
+        out.append('/');
+        value(out, v.second);
+    }
+
+    template <class T>
+    static void value(COutputBuffer &out, const std::vector<T> &v)
+    {
+        for (size_t i = 0; i < v.size(); ++i) {
+            if (i != 0) {
+                out.append(' ');
+            }
+            value(out, v[i]);
+        }
+    }
+};
+
+struct CBinaryFormat
+{
+    static size_t begin(COutputBuffer &out, uint8_t kind, const char *name)
+    {
+        size_t mark = out.size();
+        out.append_le<uint16_t>(0);
+        out.append_le<uint8_t>(kind);
+        return mark;
+    }
+
+    static void field(COutputBuffer &out, const char *name)
+    {
+    }
+
+    static constexpr size_t MAX_RECORD = 0xFFFF;
+
+    // also covers the u16 counts inside: a longer field makes the record too long
+    static bool end(COutputBuffer &out, size_t mark)
+    {
+        const size_t length = out.size() - mark - 2;
+        if (length > MAX_RECORD) {
+            out.truncate(mark);
+            return false;
+        }
+        out.patch_le16(mark, (uint16_t)length);
+        return true;
+    }
+
+    static void value(COutputBuffer &out, bool v) { out.append_le<uint8_t>(v); }
+    static void value(COutputBuffer &out, uint8_t v) { out.append_le(v); }
+    static void value(COutputBuffer &out, uint16_t v) { out.append_le(v); }
+    static void value(COutputBuffer &out, uint32_t v) { out.append_le(v); }
+    static void value(COutputBuffer &out, int64_t v) { out.append_le(v); }
+    static void value(COutputBuffer &out, uint64_t v) { out.append_le(v); }
+    static void value(COutputBuffer &out, const std::array<uint8_t, 16> &v) { out.append((const char *)v.data(), v.size()); }
+
+    static void value(COutputBuffer &out, const std::vector<uint8_t> &v)
+    {
+        out.append_le<uint16_t>((uint16_t)v.size());
+        out.append((const char *)v.data(), v.size());
+    }
+
+    template <class T>
+    static void value(COutputBuffer &out, const std::optional<T> &v)
+    {
+        out.append_le<uint8_t>(v.has_value());
+        if (v) {
+            value(out, *v);
+        }
+    }
+
+    template <class A, class B>
+    static void value(COutputBuffer &out, const std::pair<A, B> &v)
+    {
+        value(out, v.first);
+        value(out, v.second);
+    }
+
+    template <class T>
+    static void value(COutputBuffer &out, const std::vector<T> &v)
+    {
+        out.append_le<uint16_t>((uint16_t)v.size());
+        for (const auto &e : v) {
+            value(out, e);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef _SERIALIZE_OUTPUT_BUFFER_H_
+#define _SERIALIZE_OUTPUT_BUFFER_H_
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace out_detail {
+
+constexpr std::array<char, 512> make_hex_pairs()
+{
+    const char digits[] = "0123456789ABCDEF";
+    std::array<char, 512> table {};
+    for (int i = 0; i < 256; ++i) {
+        table[i * 2] = digits[i >> 4];
+        table[i * 2 + 1] = digits[i & 0x0F];
+    }
+    return table;
+}
+
+constexpr std::array<char, 200> make_dec_pairs()
+{
+    std::array<char, 200> table {};
+    for (int i = 0; i < 100; ++i) {
+        table[i * 2] = '0' + i / 10;
+        table[i * 2 + 1] = '0' + i % 10;
+    }
+    return table;
+}
+
+inline constexpr std::array<char, 512> hex_pairs = make_hex_pairs();
+inline constexpr std::array<char, 200> dec_pairs = make_dec_pairs();
+
+} // namespace out_detail
+
+/*
+  append-only byte buffer which keeps its capacity across clear(),
+  so serializing an event costs no allocation once it has grown.
+ */
+class COutputBuffer
+{
+public:
+    explicit COutputBuffer(size_t capacity = 1024)
+        : _buf(capacity), _size(0)
+    {
+    }
+
+    void clear()
+    {
+        _size = 0;
+    }
+
+    const char *data() const
+    {
+        return _buf.data();
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    // makes room for n more bytes and returns where they go
+    char *reserve(size_t n)
+    {
+        if (_size + n > _buf.size()) {
+            _buf.resize((_size + n) * 2);
+        }
+        return _buf.data() + _size;
+    }
+
+    void commit(size_t n)
+    {
+        _size += n;
+    }
+
+    // drops everything from pos on
+    void truncate(size_t pos)
+    {
+        if (pos < _size) {
+            _size = pos;
+        }
+    }
+
+    void append(char c)
+    {
+        *reserve(1) = c;
+        ++_size;
+    }
+
+    void append(const char *s, size_t n)
+    {
+        std::memcpy(reserve(n), s, n);
+        _size += n;
+    }
+
+    template <size_t size>
+    void append(const char (&s)[size])
+    {
+        append(s, size - 1);
+    }
+
+    void append_str(const char *s)
+    {
+        append(s, std::strlen(s));
+    }
+
+    void append_hex(const uint8_t *bytes, size_t n)
+    {
+        char *p = reserve(n * 2);
+        for (size_t i = 0; i < n; ++i) {
+            std::memcpy(p + i * 2, &out_detail::hex_pairs[bytes[i] * 2], 2);
+        }
+        _size += n * 2;
+    }
+
+    // value as exactly digits hex digits
+    void append_hex(uint64_t value, int digits)
+    {
+        char *p = reserve(digits);
+        for (int i = digits - 1; i >= 0; --i) {
+            p[i] = out_detail::hex_pairs[(value & 0x0F) * 2 + 1];
+            value >>= 4;
+        }
+        _size += digits;
+    }
+
+    void append_uint(uint64_t value)
+    {
+        char tmp[20];
+        char *end = tmp + sizeof(tmp);
+        char *p = end;
+        while (value >= 100) {
+            p -= 2;
+            std::memcpy(p, &out_detail::dec_pairs[(value % 100) * 2], 2);
+            value /= 100;
+        }
+        if (value >= 10) {
+            p -= 2;
+            std::memcpy(p, &out_detail::dec_pairs[value * 2], 2);
+        } else {
+            *--p = (char)('0' + value);
+        }
+        append(p, end - p);
+    }
+
+    void append_int(int64_t value)
+    {
+        if (value < 0) {
+            append('-');
+            append_uint(0 - (uint64_t)value);
+        } else {
+            append_uint((uint64_t)value);
+        }
+    }
+
+    // little endian
+    template <class T>
+    void append_le(T value)
+    {
+        char *p = reserve(sizeof(T));
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            p[i] = (char)((uint64_t)value >> (i * 8));
+        }
+        _size += sizeof(T);
+    }
+
+    // for length prefixes written after the body
+    void patch_le16(size_t pos, uint16_t value)
+    {
+        _buf[pos] = (char)value;
+        _buf[pos + 1] = (char)(value >> 8);
+    }
+
+private:
+    std::vector<char> _buf;
+    size_t _size;
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "health.h"
+#include "../command/command.h"
+
+namespace {
+
+class CDelay
+{
+public:
+    CDelay(CReactor &reactor, CReactor::msec_t msec)
+        : _reactor(reactor), _msec(msec)
+    {
+    }
+
+    bool await_ready() const
+    {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        _reactor.add_timer(_msec, [h]() { h.resume(); });
+    }
+
+    void await_resume()
+    {
+    }
+
+private:
+    CReactor &_reactor;
+    CReactor::msec_t _msec;
+};
+
+}
+
+CHealthMonitor::CHealthMonitor(CReactor &reactor, CSkSession &session, CSerial &serial, CEchonetRequester &requester,
+                               const CJoinConfig &join, const CHealthConfig &config)
+    : _reactor(reactor), _session(session), _serial(serial), _requester(requester), _join(join), _config(config),
+      _started(false), _probing(false), _terminating(false), _tx_limited(false), _port_error(0), _rekey_timer(0),
+      _last_response(0), _send_failures(0), _stats {}
+{
+}
+
+void CHealthMonitor::start(msec_t now, const CJoinResult &joined)
+{
+    _started = true;
+    _last_response = now;
+    _join.channel = joined.channel;
+    _join.pan_id = joined.pan_id;
+    _join.meter = joined.meter;
+}
+
+void CHealthMonitor::note_send(const CCommandResult &result)
+{
+    switch (result.status) {
+    case CMD_OK:
+        _send_failures = 0;
+        break;
+    case CMD_FAIL:
+        // ER10 is expected while the transmit limit holds, the scheduler backs off for that
+        if (result.error == CEvFAIL::ER_EXEC_FAILED && _tx_limited) {
+            break;
+        }
+        send_failed();
+        break;
+    case CMD_TIMEOUT:
+    case CMD_WRITE_FAILED:
+        send_failed();
+        break;
+    case CMD_ABORTED:
+        break;
+    }
+}
+
+void CHealthMonitor::send_failed()
+{
+    if (++_send_failures >= _config.max_send_failures) {
+        trigger(STALL_SEND_FAILURES);
+    }
+}
+
+void CHealthMonitor::note_event(const CEventBase &ev)
+{
+    if (ev.get_type() != EVT_EVENT) {
+        return;
+    }
+    const auto &event = static_cast<const CEvEVENT &>(ev);
+    const uint8_t num = event.num();
+
+    // the limit outlasts a recovery
+    if (num == CEvEVENT::TX_LIMIT_REACHED || num == CEvEVENT::TX_LIMIT_RELEASED) {
+        _tx_limited = num == CEvEVENT::TX_LIMIT_REACHED;
+        return;
+    }
+    if (recovering()) {
+        return;
+    }
+    switch (num) {
+    case CEvEVENT::UDP_SENT:
+        // PARAM 00 is success, anything else did not reach the air
+        if (event.param().value_or(0) != 0) {
+            send_failed();
+        } else {
+            _send_failures = 0;
+        }
+        break;
+    case CEvEVENT::SESSION_EXPIRED:
+        // the dongle re-authenticates by itself when the session lifetime
+        // runs out, only step in if that does not come through
+        if (_started && _rekey_timer == 0) {
+            _rekey_timer = _reactor.add_timer(_config.rekey_grace, [this]() {
+                _rekey_timer = 0;
+                trigger(STALL_SESSION_LOST);
+            });
+        }
+        break;
+    case CEvEVENT::PANA_CONNECTED:
+        cancel_rekey();
+        break;
+    case CEvEVENT::PANA_FAILED:
+        // the re-authentication was refused, no use waiting out the grace
+        if (_rekey_timer != 0) {
+            cancel_rekey();
+            trigger(STALL_SESSION_LOST);
+        }
+        break;
+    case CEvEVENT::SESSION_ENDED:
+        if (!_terminating) {
+            trigger(STALL_SESSION_LOST);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void CHealthMonitor::cancel_rekey()
+{
+    if (_rekey_timer != 0) {
+        _reactor.cancel_timer(_rekey_timer);
+        _rekey_timer = 0;
+    }
+}
+
+void CHealthMonitor::on_port_error(int error)
+{
+    if (!_started || recovering()) {
+        return;
+    }
+    _port_error = error;
+    trigger(STALL_PORT_ERROR);
+}
+
+void CHealthMonitor::check(msec_t now)
+{
+    if (!_started || recovering()) {
+        return;
+    }
+
+    // measured from the oldest request still without an answer, so a request
+    // after a quiet spell does not inherit the time nothing was asked
+    const msec_t unanswered = _requester.unanswered_since();
+    if (unanswered >= 0 && now - std::max(unanswered, _last_response) > _config.response_timeout) {
+        trigger(STALL_NO_RESPONSE);
+        return;
+    }
+
+    if (!_probing && now - _session.last_rx() > _config.probe_after) {
+        // SKVER is answered by the dongle itself and costs no air time
+        _probing = true;
+        std::vector<char> line;
+        CSkCommand::simple(line, "SKVER");
+        _session.submit(line, CSkSession::DEFAULT_TIMEOUT, [this](const CCommandResult &result) {
+            _probing = false;
+            if (result.status == CMD_TIMEOUT || result.status == CMD_WRITE_FAILED) {
+                trigger(STALL_DONGLE_SILENT);
+            }
+        });
+    }
+}
+
+void CHealthMonitor::trigger(CStallReason reason)
+{
+    if (!_started || recovering()) {
+        return;
+    }
+    // the recovery joins again anyway
+    cancel_rekey();
+    _recovery = recover(reason);
+    // run from the reactor, not from inside the event dispatch which noticed the stall
+    _reactor.add_timer(0, [this]() { _recovery.start(); });
+}
+
+CTask<bool> CHealthMonitor::recover(CStallReason reason)
+{
+    const msec_t began = CReactor::now();
+    ++_stats.stalls;
+    _requester.suspend();
+    _session.abort_commands();
+
+    // a silent dongle or a dead port will not answer SKTERM either
+    CRecoveryLevel level = (reason == STALL_DONGLE_SILENT || reason == STALL_PORT_ERROR) ? RECOVER_REOPEN : RECOVER_REJOIN;
+    int attempts = 0;
+    while (true) {
+        for (int i = 0; i < _config.attempts_per_level; ++i) {
+            ++attempts;
+            // the first try reuses the known PAN, later ones scan again
+            bool joined = co_await attempt(level, i > 0);
+            if (joined) {
+                const msec_t now = CReactor::now();
+                CRecoveryReport report { reason, level, attempts, now - began,
+                                         reason == STALL_PORT_ERROR ? _port_error : 0 };
+                ++_stats.recovered[level];
+                _stats.last_recovery = report.duration;
+                _stats.max_recovery = std::max(_stats.max_recovery, report.duration);
+                _stats.total_downtime += report.duration;
+
+                _last_response = now;
+                _send_failures = 0;
+                _port_error = 0;
+                _requester.resume();
+                if (_report) {
+                    _report(report);
+                }
+                co_return true;
+            }
+        }
+
+        if (level == RECOVER_USB_RESET) {
+            co_await CDelay(_reactor, _config.retry_after);
+            level = RECOVER_REOPEN;
+        } else {
+            level = (CRecoveryLevel)(level + 1);
+        }
+    }
+}
+
+CTask<bool> CHealthMonitor::attempt(CRecoveryLevel level, bool rescan)
+{
+    if (level == RECOVER_REJOIN) {
+        if (!_session.attached()) {
+            co_return false;
+        }
+        _terminating = true;
+        co_await sk_term(_session);
+        _terminating = false;
+    } else {
+        _session.detach();
+        _serial.close();
+        if (level == RECOVER_USB_RESET) {
+            if (_serial.reset_usb() < 0) {
+                co_return false;
+            }
+            co_await CDelay(_reactor, _config.usb_settle);
+        } else {
+            co_await CDelay(_reactor, _config.reopen_delay);
+        }
+        if (_serial.reopen() < 0 || _session.attach() < 0) {
+            co_return false;
+        }
+    }
+
+    CJoinConfig join = _join;
+    if (rescan) {
+        join.channel = 0;
+    }
+    CJoinResult joined = co_await sk_join(_session, join);
+    if (joined.status != JOIN_OK) {
+        co_return false;
+    }
+    _join.channel = joined.channel;
+    _join.pan_id = joined.pan_id;
+    _join.meter = joined.meter;
+    co_return true;
+}
@@ -0,0 +1,144 @@
+#ifndef _SESSION_HEALTH_H_
+#define _SESSION_HEALTH_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+#include "join.h"
+#include "sk_session.h"
+#include "task.h"
+#include "../echonet/requester.h"
+
+struct CHealthConfig
+{
+    using msec_t = CReactor::msec_t;
+
+    msec_t probe_after = 60 * 1000;             // silence on the port before SKVER checks the dongle
+    msec_t rekey_grace = 30 * 1000;             // EVENT 29 until the dongle's own re-authentication (EVENT 25)
+    msec_t response_timeout = 3 * 60 * 1000;    // no ECHONET answer while requests are outstanding
+    int max_send_failures = 5;                  // SKSENDTO failures in a row
+    int attempts_per_level = 2;
+    msec_t reopen_delay = 1000;
+    msec_t usb_settle = 5000;                   // for the tty to come back after a USB reset
+    msec_t retry_after = 60 * 1000;             // after every level failed, before starting over
+};
+
+enum CStallReason {
+    STALL_NO_RESPONSE,
+    STALL_SEND_FAILURES,
+    STALL_DONGLE_SILENT,        // SKVER went unanswered
+    STALL_SESSION_LOST,         // EVENT 29 not followed by EVENT 25, or EVENT 27 we did not ask for
+    STALL_PORT_ERROR,
+};
+
+enum CRecoveryLevel {
+    RECOVER_REJOIN,             // SKTERM, then the join sequence
+    RECOVER_REOPEN,             // close and open the serial port, then join
+    RECOVER_USB_RESET,          // USBDEVFS_RESET, reopen, then join
+    RECOVER_LEVEL_COUNT,
+};
+
+struct CRecoveryReport
+{
+    CStallReason reason;
+    CRecoveryLevel level;       // the one which worked
+    int attempts;
+    CReactor::msec_t duration;  // stall detected to joined again
+    int error;                  // STALL_PORT_ERROR: what the port reported, 0 otherwise
+};
+
+struct CHealthStats
+{
+    uint32_t stalls;
+    uint32_t recovered[RECOVER_LEVEL_COUNT];
+    CReactor::msec_t last_recovery;
+    CReactor::msec_t max_recovery;
+    CReactor::msec_t total_downtime;
+};
+
+/*
+  watches the dongle and the PANA session and brings them back in
+  process, escalating from a re-join to a port reopen to a USB reset.
+
+  the requester is suspended for the duration, so queued and in-flight
+  requests survive the outage and go out once the session is back;
+  the poll scheduler and backfill keep queueing meanwhile.
+ */
+class CHealthMonitor
+{
+public:
+    using msec_t = CReactor::msec_t;
+    using report_callback_type = std::function<void(const CRecoveryReport &report)>;
+
+    CHealthMonitor(CReactor &reactor, CSkSession &session, CSerial &serial, CEchonetRequester &requester,
+                   const CJoinConfig &join, const CHealthConfig &config = CHealthConfig());
+
+    // once the first join has succeeded, recovery joins the same PAN first
+    void start(msec_t now, const CJoinResult &joined);
+
+    void note_response(msec_t now)
+    {
+        _last_response = now;
+    }
+
+    // result of an SKSENDTO. FAIL ER10 counts as a failure unless EVENT 32
+    // says the transmit limit is in force
+    void note_send(const CCommandResult &result);
+
+    // EVENT 21 with a non-zero PARAM is a send which did not go out
+    void note_event(const CEventBase &ev);
+
+    // error as given to the session's error handler, kept for the report
+    void on_port_error(int error);
+
+    // from a periodic timer
+    void check(msec_t now);
+
+    bool recovering() const
+    {
+        return !_recovery.done();
+    }
+
+    void set_report_handler(report_callback_type handler)
+    {
+        _report = std::move(handler);
+    }
+
+    const CHealthStats &get_stats() const
+    {
+        return _stats;
+    }
+
+private:
+    CReactor &_reactor;
+    CSkSession &_session;
+    CSerial &_serial;
+    CEchonetRequester &_requester;
+    CJoinConfig _join;
+    CHealthConfig _config;
+    report_callback_type _report;
+
+    bool _started;
+    bool _probing;
+    bool _terminating;          // our own SKTERM, its EVENT 27 is expected
+    bool _tx_limited;           // between EVENT 32 and EVENT 33
+    int _port_error;
+    CReactor::timer_id _rekey_timer;    // waiting for EVENT 25 after EVENT 29, 0 otherwise
+    msec_t _last_response;
+    int _send_failures;
+    CHealthStats _stats;
+    CTask<bool> _recovery;
+
+    void trigger(CStallReason reason);
+
+    void send_failed();
+
+    void cancel_rekey();
+
+    CTask<bool> recover(CStallReason reason);
+
+    CTask<bool> attempt(CRecoveryLevel level, bool rescan);
+};
+
+#endif
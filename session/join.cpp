@@ -0,0 +1,137 @@
+#include <memory>
+
+#include "join.h"
+#include "../command/command.h"
+
+namespace {
+
+const CSkSession::msec_t PANA_TIMEOUT = 60 * 1000;
+
+// one SKSCAN over all channels takes about 2^duration * 0.96 msec * 28 channels
+CSkSession::msec_t scan_timeout(uint8_t duration)
+{
+    return ((1LL << duration) * 96 / 100 + 100) * 28 + 10 * 1000;
+}
+
+bool is_ok(const CCommandResult &result)
+{
+    return result.status == CMD_OK;
+}
+
+// SKSCAN with longer durations until a PAN answers, keeps the last EPANDESC
+CTask<CJoinStatus> scan(CSkSession &session, const CJoinConfig &config, CJoinResult &result)
+{
+    std::vector<char> line;
+    std::unique_ptr<CEvEPANDESC> pan;
+    uint8_t duration = config.first_scan_duration;
+    for (int i = 0; i < config.scan_retries && !pan; ++i, ++duration) {
+        CSkCommand::scan(line, 2, 0xFFFFFFFF, duration);
+        if (!is_ok(co_await session.command(line))) {
+            co_return JOIN_COMMAND_FAILED;
+        }
+        while (true) {
+            auto ev = co_await session.wait_for([](const CEventBase &e) {
+                return e.get_type() == EVT_EPANDESC
+                    || (e.get_type() == EVT_EVENT && static_cast<const CEvEVENT &>(e).num() == CEvEVENT::ACTIVE_SCAN_DONE);
+            }, scan_timeout(duration));
+            if (!ev || ev->get_type() == EVT_EVENT) {
+                break;
+            }
+            pan.reset(static_cast<CEvEPANDESC *>(ev.release()));
+        }
+    }
+    if (!pan) {
+        co_return JOIN_NOT_FOUND;
+    }
+
+    result.channel = pan->channel();
+    result.pan_id = pan->pan_id();
+    result.meter = link_local_from_mac(pan->addr());
+    co_return JOIN_OK;
+}
+
+}
+
+node_addr_t link_local_from_mac(uint64_t mac)
+{
+    node_addr_t addr {};
+    addr[0] = 0xFE;
+    addr[1] = 0x80;
+    for (int i = 0; i < 8; ++i) {
+        addr[8 + i] = (uint8_t)(mac >> ((7 - i) * 8));
+    }
+    addr[8] ^= 0x02;
+    return addr;
+}
+
+CTask<CJoinResult> sk_join(CSkSession &session, CJoinConfig config)
+{
+    CJoinResult result { JOIN_COMMAND_FAILED, {}, 0, 0 };
+    std::vector<char> line;
+
+    // no echo back, it only costs parsing
+    CSkCommand::sreg(line, "SFE", 0, 1);
+    co_await session.command(line);
+
+    CSkCommand::simple(line, "SKVER");
+    if (!is_ok(co_await session.command(line))) {
+        co_return result;
+    }
+    CSkCommand::setpwd(line, config.password.c_str());
+    if (!is_ok(co_await session.command(line))) {
+        co_return result;
+    }
+    CSkCommand::setrbid(line, config.route_b_id.c_str());
+    if (!is_ok(co_await session.command(line))) {
+        co_return result;
+    }
+
+    if (config.channel != 0) {
+        result.channel = config.channel;
+        result.pan_id = config.pan_id;
+        result.meter = config.meter;
+    } else {
+        CJoinStatus status = co_await scan(session, config, result);
+        if (status != JOIN_OK) {
+            result.status = status;
+            co_return result;
+        }
+    }
+
+    CSkCommand::sreg(line, "S2", result.channel, 2);
+    if (!is_ok(co_await session.command(line))) {
+        co_return result;
+    }
+    CSkCommand::sreg(line, "S3", result.pan_id, 4);
+    if (!is_ok(co_await session.command(line))) {
+        co_return result;
+    }
+    CSkCommand::join(line, result.meter);
+    if (!is_ok(co_await session.command(line))) {
+        co_return result;
+    }
+
+    // built outside the co_await, g++ 12 cannot keep an initializer_list in a coroutine frame
+    auto joined = session.wait_for_event({ CEvEVENT::PANA_CONNECTED, CEvEVENT::PANA_FAILED }, PANA_TIMEOUT);
+    auto ev = co_await joined;
+    if (!ev) {
+        result.status = JOIN_TIMEOUT;
+    } else if (static_cast<const CEvEVENT &>(*ev).num() == CEvEVENT::PANA_CONNECTED) {
+        result.status = JOIN_OK;
+    } else {
+        result.status = JOIN_PANA_FAILED;
+    }
+    co_return result;
+}
+
+CTask<bool> sk_term(CSkSession &session)
+{
+    std::vector<char> line;
+    CSkCommand::simple(line, "SKTERM");
+    if (!is_ok(co_await session.command(line))) {
+        co_return false;
+    }
+    auto ended = session.wait_for_event({ CEvEVENT::SESSION_ENDED, CEvEVENT::SESSION_END_TIMEOUT }, PANA_TIMEOUT);
+    auto ev = co_await ended;
+    co_return (bool)ev;
+}
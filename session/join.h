@@ -0,0 +1,51 @@
+#ifndef _SESSION_JOIN_H_
+#define _SESSION_JOIN_H_
+
+#include <string>
+
+#include "sk_session.h"
+#include "../echonet/echonet.h"
+#include "task.h"
+
+struct CJoinConfig
+{
+    std::string route_b_id;         // 32 characters
+    std::string password;           // 12 characters
+    int scan_retries = 5;
+    uint8_t first_scan_duration = 6;
+
+    // a PAN found earlier. with channel set SKSCAN is skipped
+    uint8_t channel = 0;
+    uint16_t pan_id = 0;
+    node_addr_t meter {};
+};
+
+enum CJoinStatus {
+    JOIN_OK,
+    JOIN_COMMAND_FAILED,
+    JOIN_NOT_FOUND,
+    JOIN_PANA_FAILED,
+    JOIN_TIMEOUT,
+};
+
+struct CJoinResult
+{
+    CJoinStatus status;
+    node_addr_t meter;
+    uint8_t channel;
+    uint16_t pan_id;
+};
+
+// link-local address of a node from its 64bit MAC (what SKLL64 prints)
+node_addr_t link_local_from_mac(uint64_t mac);
+
+/*
+  SKSREG SFE 0 -> SKVER -> SKSETPWD -> SKSETRBID -> SKSCAN ... EPANDESC,
+  EVENT 22 -> SKSREG S2 -> SKSREG S3 -> SKJOIN -> EVENT 25 / 24
+ */
+CTask<CJoinResult> sk_join(CSkSession &session, CJoinConfig config);
+
+// SKTERM and wait for the session to end
+CTask<bool> sk_term(CSkSession &session);
+
+#endif
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <vector>
+
+#include "sk_session.h"
+
+namespace {
+// how long an abandoned command may still hold the line
+const CSkSession::msec_t ABANDON_GRACE = 2000;
+}
+
+CSkSession::CSkSession(CReactor &reactor, CSerial &serial)
+    : _reactor(reactor), _serial(serial), _attached(false), _last_rx(0), _command_timer(0), _next_wait(1)
+{
+}
+
+CSkSession::~CSkSession()
+{
+    detach();
+    for (auto &waiter : _waiters) {
+        _reactor.cancel_timer(waiter.timer);
+    }
+    _reactor.cancel_timer(_command_timer);
+}
+
+int CSkSession::attach()
+{
+    if (!_serial.is_opened()) {
+        return E_NOT_OPENED;
+    }
+    // the reactor says when there is something to read
+    _serial.set_timeout(0);
+    _reader.clear();
+    if (!_commands.empty() && _commands.front().abandoned) {
+        // a reopened port will not answer for the old one
+        _reactor.cancel_timer(_command_timer);
+        _commands.pop_front();
+    }
+    int ret = _reactor.add_fd(_serial.get_fd(), EPOLLIN, [this](uint32_t events) { on_readable(events); });
+    if (ret < 0) {
+        return ret;
+    }
+    _attached = true;
+    pump();
+    return 0;
+}
+
+void CSkSession::detach()
+{
+    if (!_attached) {
+        return;
+    }
+    _reactor.remove_fd(_serial.get_fd());
+    _attached = false;
+}
+
+void CSkSession::set_filter(CEventFilter *filter)
+{
+    if (filter != nullptr) {
+        CSubscription own;
+        own.types = CSubscription::type_bit(EVT_OK) | CSubscription::type_bit(EVT_FAIL)
+                  | CSubscription::type_bit(EVT_EVENT) | CSubscription::type_bit(EVT_EPANDESC)
+                  | CSubscription::type_bit(EVT_EADDR) | CSubscription::type_bit(EVT_ENEIGHBOR);
+        filter->subscribe(own);
+    }
+    _reader.set_filter(filter);
+}
+
+void CSkSession::submit(std::vector<char> command, msec_t timeout, command_callback_type callback)
+{
+    _commands.push_back(CCommand { std::move(command), timeout, std::move(callback), false, false });
+    pump();
+}
+
+CSkSession::wait_id CSkSession::wait(predicate_type predicate, msec_t timeout, event_callback_type callback)
+{
+    wait_id id = _next_wait++;
+    CReactor::timer_id timer = _reactor.add_timer(timeout, [this, id]() {
+        auto it = std::find_if(_waiters.begin(), _waiters.end(), [id](const CWaiter &w) { return w.id == id; });
+        if (it == _waiters.end()) {
+            return;
+        }
+        event_callback_type callback = std::move(it->callback);
+        _waiters.erase(it);
+        callback(nullptr);
+    });
+    _waiters.push_back(CWaiter { id, std::move(predicate), std::move(callback), timer });
+    return id;
+}
+
+void CSkSession::cancel_wait(wait_id id)
+{
+    auto it = std::find_if(_waiters.begin(), _waiters.end(), [id](const CWaiter &w) { return w.id == id; });
+    if (it == _waiters.end()) {
+        return;
+    }
+    _reactor.cancel_timer(it->timer);
+    _waiters.erase(it);
+}
+
+CSkSession::CEventAwaiter CSkSession::wait_for_event(std::initializer_list<uint8_t> nums, msec_t timeout)
+{
+    std::vector<uint8_t> wanted(nums);
+    return wait_for([wanted](const CEventBase &ev) {
+        if (ev.get_type() != EVT_EVENT) {
+            return false;
+        }
+        uint8_t num = static_cast<const CEvEVENT &>(ev).num();
+        return std::find(wanted.begin(), wanted.end(), num) != wanted.end();
+    }, timeout);
+}
+
+void CSkSession::abort_commands()
+{
+    _reactor.cancel_timer(_command_timer);
+    const bool written = !_commands.empty() && _commands.front().written;
+    std::deque<CCommand> commands;
+    commands.swap(_commands);
+    for (auto &command : commands) {
+        if (!command.abandoned && command.callback) {
+            _reactor.add_timer(0, [callback = std::move(command.callback)]() {
+                callback(CCommandResult { CMD_ABORTED, 0, {} });
+            });
+        }
+    }
+
+    if (written) {
+        // its OK / FAIL may still come, keep it from answering the next command
+        _commands.push_back(CCommand { {}, 0, nullptr, true, true });
+        _command_timer = _reactor.add_timer(ABANDON_GRACE, [this]() { on_command_timeout(); });
+    }
+}
+
+void CSkSession::on_readable(uint32_t events)
+{
+    long len = _reader.read_from(_serial);
+    if (len < 0 || (len == 0 && (events & (EPOLLERR | EPOLLHUP)))) {
+        // unplugged or wedged, stop polling a dead fd
+        detach();
+        if (_error_handler) {
+            _error_handler(len < 0 ? (int)len : E_READ_FAILED);
+        }
+        return;
+    }
+    if (len == 0) {
+        return;
+    }
+    _last_rx = CReactor::now();
+
+    ptr_type ev;
+    while (_reader.next(ev) == EV_MATCHED) {
+        dispatch(std::move(ev));
+    }
+}
+
+void CSkSession::dispatch(ptr_type ev)
+{
+    if (_handler) {
+        _handler(*ev);
+    }
+
+    const CEventType type = ev->get_type();
+    if ((type == EVT_OK || type == EVT_FAIL) && !_commands.empty() && _commands.front().written) {
+        CCommandResult result { CMD_OK, 0, {} };
+        if (type == EVT_OK) {
+            result.value = static_cast<const CEvOK &>(*ev).value();
+        } else {
+            result.status = CMD_FAIL;
+            result.error = static_cast<const CEvFAIL &>(*ev).error();
+        }
+        complete(result);
+        return;
+    }
+
+    for (auto it = _waiters.begin(); it != _waiters.end(); ++it) {
+        if (it->predicate(*ev)) {
+            event_callback_type callback = std::move(it->callback);
+            _reactor.cancel_timer(it->timer);
+            _waiters.erase(it);
+            callback(std::move(ev));
+            return;
+        }
+    }
+}
+
+void CSkSession::pump()
+{
+    if (!_attached || _commands.empty() || _commands.front().written) {
+        return;
+    }
+
+    CCommand &head = _commands.front();
+    size_t ret = _serial.write(head.line.data(), head.line.size());
+    if (ret != head.line.size()) {
+        // report from the reactor so that awaiters are never resumed inside submit()
+        command_callback_type callback = std::move(head.callback);
+        _commands.pop_front();
+        if (callback) {
+            _reactor.add_timer(0, [callback]() { callback(CCommandResult { CMD_WRITE_FAILED, 0, {} }); });
+        }
+        pump();
+        return;
+    }
+
+    head.written = true;
+    _command_timer = _reactor.add_timer(head.timeout, [this]() { on_command_timeout(); });
+}
+
+void CSkSession::complete(const CCommandResult &result)
+{
+    _reactor.cancel_timer(_command_timer);
+    CCommand head = std::move(_commands.front());
+    _commands.pop_front();
+
+    if (!head.abandoned && head.callback) {
+        head.callback(result);
+    }
+    pump();
+}
+
+void CSkSession::on_command_timeout()
+{
+    if (_commands.empty() || !_commands.front().written) {
+        return;
+    }
+
+    CCommand &head = _commands.front();
+    if (head.abandoned) {
+        // the answer never came, let the next command go
+        _commands.pop_front();
+        pump();
+        return;
+    }
+
+    head.abandoned = true;
+    command_callback_type callback = std::move(head.callback);
+    _command_timer = _reactor.add_timer(ABANDON_GRACE, [this]() { on_command_timeout(); });
+    if (callback) {
+        callback(CCommandResult { CMD_TIMEOUT, 0, {} });
+    }
+}
@@ -0,0 +1,237 @@
+#ifndef _SESSION_SK_SESSION_H_
+#define _SESSION_SK_SESSION_H_
+
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <list>
+#include <optional>
+#include <vector>
+
+#include "../event/skevents.h"
+#include "../event/event_reader.h"
+#include "../reactor/reactor.h"
+#include "../serial/serial.h"
+
+enum CCommandStatus {
+    CMD_OK,
+    CMD_FAIL,
+    CMD_TIMEOUT,
+    CMD_WRITE_FAILED,
+    CMD_ABORTED,        // abort_commands(), the port is being recovered
+};
+
+struct CCommandResult
+{
+    CCommandStatus status;
+    uint8_t error;                  // ER<NN> when CMD_FAIL
+    std::optional<uint8_t> value;   // "OK <NN>"
+};
+
+/*
+  one dongle driven from the reactor.
+
+  SKSTACK answers commands one at a time with an untagged OK / FAIL, so
+  commands are queued and written one after the other. any number of
+  coroutines (and plain callbacks) may use the session at once:
+
+      auto r = co_await session.command(line);
+      auto ev = co_await session.wait_for_event({ CEvEVENT::PANA_CONNECTED }, 30000);
+
+  every event is given to the event handler first, then to the oldest
+  waiter whose predicate accepts it.
+ */
+class CSkSession
+{
+public:
+    using msec_t = CReactor::msec_t;
+    using ptr_type = CSkEventDispatcher::ptr_type;
+    using command_callback_type = std::function<void(const CCommandResult &result)>;
+    using event_callback_type = std::function<void(ptr_type ev)>;
+    using predicate_type = std::function<bool(const CEventBase &ev)>;
+    using handler_type = std::function<void(const CEventBase &ev)>;
+    using error_handler_type = std::function<void(int error)>;
+    using wait_id = uint64_t;
+
+    static constexpr msec_t DEFAULT_TIMEOUT = 5000;
+
+    CSkSession(CReactor &reactor, CSerial &serial);
+
+    ~CSkSession();
+
+    // starts reading the port from the reactor. bytes left over from an
+    // earlier attach are dropped
+    int attach();
+
+    void detach();
+
+    bool attached() const
+    {
+        return _attached;
+    }
+
+    void set_event_handler(handler_type handler)
+    {
+        _handler = std::move(handler);
+    }
+
+    // the port hung up or failed to read. the session is detached already
+    void set_error_handler(error_handler_type handler)
+    {
+        _error_handler = std::move(handler);
+    }
+
+    // events the filter drops never reach the handler or the waiters.
+    // the session subscribes the responses and notifications it needs itself.
+    void set_filter(CEventFilter *filter);
+
+    // callback runs from the reactor, never from inside submit()
+    void submit(std::vector<char> command, msec_t timeout, command_callback_type callback);
+
+    // callback gets the first matching event, or nullptr on timeout
+    wait_id wait(predicate_type predicate, msec_t timeout, event_callback_type callback);
+
+    void cancel_wait(wait_id id);
+
+    // fails every queued command with CMD_ABORTED, from the reactor
+    void abort_commands();
+
+    size_t pending_commands() const
+    {
+        return _commands.size();
+    }
+
+    // bytes of overlong lines the reader threw away
+    unsigned long long discarded() const
+    {
+        return _reader.discarded();
+    }
+
+    // when the last byte came from the port, 0 before any
+    msec_t last_rx() const
+    {
+        return _last_rx;
+    }
+
+    class CCommandAwaiter
+    {
+    public:
+        CCommandAwaiter(CSkSession &session, std::vector<char> command, msec_t timeout)
+            : _session(session), _command(std::move(command)), _timeout(timeout), _result { CMD_TIMEOUT, 0, {} }
+        {
+        }
+
+        bool await_ready() const
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            _session.submit(std::move(_command), _timeout, [this, h](const CCommandResult &result) {
+                _result = result;
+                h.resume();
+            });
+        }
+
+        CCommandResult await_resume()
+        {
+            return _result;
+        }
+
+    private:
+        CSkSession &_session;
+        std::vector<char> _command;
+        msec_t _timeout;
+        CCommandResult _result;
+    };
+
+    class CEventAwaiter
+    {
+    public:
+        CEventAwaiter(CSkSession &session, predicate_type predicate, msec_t timeout)
+            : _session(session), _predicate(std::move(predicate)), _timeout(timeout)
+        {
+        }
+
+        bool await_ready() const
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            _session.wait(std::move(_predicate), _timeout, [this, h](ptr_type ev) {
+                _event = std::move(ev);
+                h.resume();
+            });
+        }
+
+        // nullptr on timeout
+        ptr_type await_resume()
+        {
+            return std::move(_event);
+        }
+
+    private:
+        CSkSession &_session;
+        predicate_type _predicate;
+        msec_t _timeout;
+        ptr_type _event;
+    };
+
+    CCommandAwaiter command(std::vector<char> line, msec_t timeout = DEFAULT_TIMEOUT)
+    {
+        return CCommandAwaiter(*this, std::move(line), timeout);
+    }
+
+    CEventAwaiter wait_for(predicate_type predicate, msec_t timeout)
+    {
+        return CEventAwaiter(*this, std::move(predicate), timeout);
+    }
+
+    // EVENT <NUM> for any of nums
+    CEventAwaiter wait_for_event(std::initializer_list<uint8_t> nums, msec_t timeout);
+
+private:
+    struct CCommand
+    {
+        std::vector<char> line;
+        msec_t timeout;
+        command_callback_type callback;
+        bool written;
+        bool abandoned;     // timed out, its late OK / FAIL is still to come
+    };
+
+    struct CWaiter
+    {
+        wait_id id;
+        predicate_type predicate;
+        event_callback_type callback;
+        CReactor::timer_id timer;
+    };
+
+    CReactor &_reactor;
+    CSerial &_serial;
+    CEventReader<CSkEventDispatcher> _reader;
+    handler_type _handler;
+    error_handler_type _error_handler;
+    bool _attached;
+    msec_t _last_rx;
+
+    std::deque<CCommand> _commands;
+    CReactor::timer_id _command_timer;
+
+    std::list<CWaiter> _waiters;
+    wait_id _next_wait;
+
+    void on_readable(uint32_t events);
+    void dispatch(ptr_type ev);
+    void pump();
+    void complete(const CCommandResult &result);
+    void on_command_timeout();
+};
+
+#endif
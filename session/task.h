@@ -0,0 +1,148 @@
+#ifndef _SESSION_TASK_H_
+#define _SESSION_TASK_H_
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+/*
+  lazily started coroutine returning T.
+
+  co_await task starts it and resumes the awaiting coroutine when it
+  returns, without going through the reactor. a top level task is
+  started with start() and must be kept alive until done().
+ */
+template <class T>
+class CTask
+{
+public:
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::coroutine_handle<> continuation;
+
+        CTask get_return_object()
+        {
+            return CTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        struct final_awaiter
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+            {
+                auto continuation = h.promise().continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept
+            {
+            }
+        };
+
+        final_awaiter final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_value(T v)
+        {
+            value = std::move(v);
+        }
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    CTask()
+        : _handle(nullptr)
+    {
+    }
+
+    explicit CTask(handle_type h)
+        : _handle(h)
+    {
+    }
+
+    CTask(CTask &&other) noexcept
+        : _handle(std::exchange(other._handle, nullptr))
+    {
+    }
+
+    CTask &operator=(CTask &&other) noexcept
+    {
+        if (this != &other) {
+            destroy();
+            _handle = std::exchange(other._handle, nullptr);
+        }
+        return *this;
+    }
+
+    CTask(const CTask &) = delete;
+    CTask &operator=(const CTask &) = delete;
+
+    ~CTask()
+    {
+        destroy();
+    }
+
+    void start()
+    {
+        if (_handle && !_handle.done()) {
+            _handle.resume();
+        }
+    }
+
+    bool done() const
+    {
+        return !_handle || _handle.done();
+    }
+
+    T &result()
+    {
+        return *_handle.promise().value;
+    }
+
+    bool await_ready() const
+    {
+        return done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+    {
+        _handle.promise().continuation = awaiting;
+        return _handle;
+    }
+
+    T await_resume()
+    {
+        return std::move(*_handle.promise().value);
+    }
+
+private:
+    handle_type _handle;
+
+    void destroy()
+    {
+        if (_handle) {
+            _handle.destroy();
+            _handle = nullptr;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef _SHM_FUTEX_H_
+#define _SHM_FUTEX_H_
+
+#include <atomic>
+#include <cstdint>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// shared (not FUTEX_PRIVATE) so that waiters in other processes are found
+
+inline int shm_futex_wait(const std::atomic<uint32_t> *word, uint32_t expected, const timespec *timeout)
+{
+    return syscall(SYS_futex, word, FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+inline int shm_futex_wake_all(std::atomic<uint32_t> *word)
+{
+    return syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+#endif
@@ -0,0 +1,294 @@
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <new>
+
+#include "shm_publisher.h"
+#include "shm_futex.h"
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010      // linux 5.1
+#endif
+
+CShmPublisher::~CShmPublisher()
+{
+    close();
+}
+
+int CShmPublisher::create(const char *name, uint32_t slot_count, uint32_t slot_size)
+{
+#ifdef DEBUG_SHM
+    fprintf(stderr, "[DEBUG] CShmPublisher::create(\"%s\", %u, %u)\n", name, slot_count, slot_size);
+#endif
+    if (name == nullptr || !shm_valid_geometry(slot_count, slot_size)) {
+        return E_SHM_INVALID_ARG;
+    }
+    if (is_opened()) {
+        close();
+    }
+
+    int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd < 0) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmPublisher::create(...): E_SHM_CREATE_FAILED\n"
+                        "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+#endif
+        return E_SHM_CREATE_FAILED;
+    }
+
+    long size = shm_ring_size(slot_count, slot_size);
+    if (ftruncate(fd, size) < 0) {
+        ::close(fd);
+        return E_SHM_CREATE_FAILED;
+    }
+    // consumers must never see the mapping change size under them
+    fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW);
+
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmPublisher::create(...): E_SHM_MAP_FAILED\n"
+                        "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+#endif
+        ::close(fd);
+        return E_SHM_MAP_FAILED;
+    }
+
+    // from here on no fd, ours included, can create another writable mapping
+    if (fcntl(fd, F_ADD_SEALS, F_SEAL_FUTURE_WRITE | F_SEAL_SEAL) < 0) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmPublisher::create(...): F_SEAL_FUTURE_WRITE unsupported, "
+                        "relying on the read-only fd\n");
+#endif
+        fcntl(fd, F_ADD_SEALS, F_SEAL_SEAL);
+    }
+
+    // consumers get an fd opened read-only, they cannot mmap it writable
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+    int reader_fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (reader_fd < 0) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmPublisher::create(...): E_SHM_CREATE_FAILED\n"
+                        "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+#endif
+        munmap(base, size);
+        ::close(fd);
+        return E_SHM_CREATE_FAILED;
+    }
+
+    int wait_fd = memfd_create("raspi-echonet-waiters", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    void *waiters = MAP_FAILED;
+    if (wait_fd >= 0 && ftruncate(wait_fd, sizeof(CShmWaiters)) == 0) {
+        fcntl(wait_fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+        waiters = mmap(nullptr, sizeof(CShmWaiters), PROT_READ | PROT_WRITE, MAP_SHARED, wait_fd, 0);
+    }
+    if (waiters == MAP_FAILED) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmPublisher::create(...): E_SHM_CREATE_FAILED\n"
+                        "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+#endif
+        if (wait_fd >= 0) {
+            ::close(wait_fd);
+        }
+        ::close(reader_fd);
+        munmap(base, size);
+        ::close(fd);
+        return E_SHM_CREATE_FAILED;
+    }
+
+    auto *h = new (base) CShmRingHeader;
+    h->magic = SHM_RING_MAGIC;
+    h->version = SHM_RING_VERSION;
+    h->slot_count = slot_count;
+    h->slot_size = slot_size;
+    h->write_seq.store(0, std::memory_order_relaxed);
+    h->futex_word.store(0, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < slot_count; ++i) {
+        auto *slot = new (shm_slot_at(base, i, slot_count, slot_size)) CShmSlot;
+        slot->seq.store(0, std::memory_order_relaxed);
+    }
+
+    auto *w = new (waiters) CShmWaiters;
+    w->count.store(0, std::memory_order_relaxed);
+
+    _memfd = fd;
+    _reader_fd = reader_fd;
+    _wait_fd = wait_fd;
+    _base = base;
+    _size = size;
+    _waiters = w;
+    _slot_count = slot_count;
+    _slot_size = slot_size;
+    _write_seq = 0;
+    _writing = nullptr;
+    _dropped = 0;
+    return 0;
+}
+
+int CShmPublisher::listen(const char *socket_path, mode_t mode)
+{
+#ifdef DEBUG_SHM
+    fprintf(stderr, "[DEBUG] CShmPublisher::listen(\"%s\", %o)\n", socket_path, mode);
+#endif
+    sockaddr_un addr;
+    if (socket_path == nullptr || strlen(socket_path) >= sizeof(addr.sun_path)) {
+        return E_SHM_INVALID_ARG;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return E_SHM_SOCKET_FAILED;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);
+
+    // the socket file is created with mode already applied, there is no
+    // window in which anybody else could connect
+    mode_t old_mask = umask(~mode & 0777);
+    int ret = bind(fd, (sockaddr *)&addr, sizeof(addr));
+    umask(old_mask);
+    if (ret < 0 || chmod(socket_path, mode) < 0 || ::listen(fd, 8) < 0) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmPublisher::listen(...): E_SHM_SOCKET_FAILED\n"
+                        "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+#endif
+        ::close(fd);
+        return E_SHM_SOCKET_FAILED;
+    }
+
+    _listen_fd = fd;
+    return 0;
+}
+
+int CShmPublisher::serve()
+{
+    if (_listen_fd < 0 || !is_opened()) {
+        return E_SHM_NOT_OPENED;
+    }
+
+    int served = 0;
+    while (true) {
+        int client = accept4(_listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            break;
+        }
+
+        char byte = 0;
+        iovec iov = { &byte, 1 };
+        union {
+            cmsghdr align;
+            char buf[CMSG_SPACE(2 * sizeof(int))];
+        } control;
+        memset(&control, 0, sizeof(control));
+        const int fds[2] = { _reader_fd, _wait_fd };
+
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+        if (sendmsg(client, &msg, MSG_NOSIGNAL) == 1) {
+            ++served;
+        }
+        ::close(client);
+    }
+    return served;
+}
+
+void CShmPublisher::close()
+{
+    if (_listen_fd >= 0) {
+        ::close(_listen_fd);
+        _listen_fd = CLOSED;
+    }
+    if (_base != nullptr) {
+        munmap(_base, _size);
+        _base = nullptr;
+        _size = 0;
+    }
+    if (_waiters != nullptr) {
+        munmap(_waiters, sizeof(CShmWaiters));
+        _waiters = nullptr;
+    }
+    if (_reader_fd >= 0) {
+        ::close(_reader_fd);
+        _reader_fd = CLOSED;
+    }
+    if (_wait_fd >= 0) {
+        ::close(_wait_fd);
+        _wait_fd = CLOSED;
+    }
+    if (_memfd >= 0) {
+        ::close(_memfd);
+        _memfd = CLOSED;
+    }
+    _writing = nullptr;
+}
+
+void *CShmPublisher::begin(uint16_t type, uint32_t length)
+{
+    if (!is_opened() || _writing != nullptr) {
+        return nullptr;
+    }
+    if (length > shm_slot_capacity(_slot_size)) {
+        ++_dropped;
+        return nullptr;
+    }
+
+    CShmSlot *slot = shm_slot_at(_base, _write_seq, _slot_count, _slot_size);
+    slot->seq.store(_write_seq * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->type = type;
+    slot->length = length;
+
+    _writing = slot;
+    return slot->data;
+}
+
+void CShmPublisher::commit()
+{
+    if (_writing == nullptr) {
+        return;
+    }
+
+    _writing->seq.store(_write_seq * 2 + 2, std::memory_order_release);
+    _writing = nullptr;
+    ++_write_seq;
+
+    header()->write_seq.store(_write_seq, std::memory_order_release);
+    // seq_cst on both sides: either a reader going to sleep sees the new
+    // futex_word, or we see it in the waiter count
+    header()->futex_word.fetch_add(1, std::memory_order_seq_cst);
+    if (_waiters->count.load(std::memory_order_seq_cst) != 0) {
+        shm_futex_wake_all(&header()->futex_word);
+    }
+}
+
+int CShmPublisher::publish(uint16_t type, const void *data, uint32_t length)
+{
+    void *p = begin(type, length);
+    if (p == nullptr) {
+        return E_SHM_INVALID_ARG;
+    }
+    memcpy(p, data, length);
+    commit();
+    return 0;
+}
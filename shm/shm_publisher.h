@@ -0,0 +1,99 @@
+#ifndef _SHM_PUBLISHER_H_
+#define _SHM_PUBLISHER_H_
+
+#include <cstdint>
+#include <sys/types.h>
+
+#include "shm_ring.h"
+
+/*
+  gateway side of the ring. the ring lives in a memfd which is handed to
+  consumers over a unix socket (SCM_RIGHTS). they get a read-only fd and
+  the memfd is sealed against new writable mappings, so only the
+  gateway's own mapping can write to it. the waiter count (CShmWaiters)
+  is handed out next to it, writable.
+
+      void *p = publisher.begin(type, length);
+      ... write the record straight into p ...
+      publisher.commit();
+ */
+class CShmPublisher
+{
+public:
+    const int CLOSED = -1;
+
+    CShmPublisher()
+        : _memfd(CLOSED), _reader_fd(CLOSED), _wait_fd(CLOSED), _listen_fd(CLOSED), _base(nullptr),
+          _size(0), _waiters(nullptr),
+          _slot_count(0), _slot_size(0), _write_seq(0), _writing(nullptr), _dropped(0)
+    {
+    }
+
+    ~CShmPublisher();
+
+    int create(const char *name, uint32_t slot_count = 1024, uint32_t slot_size = 512);
+
+    // socket which consumers connect to to receive the memfd.
+    // only users allowed by mode can connect
+    int listen(const char *socket_path, mode_t mode = 0600);
+
+    // hands the memfd to every pending connection. never blocks.
+    int serve();
+
+    void close();
+
+    // nullptr if the record does not fit in a slot (counted in dropped())
+    void *begin(uint16_t type, uint32_t length);
+
+    void commit();
+
+    int publish(uint16_t type, const void *data, uint32_t length);
+
+    bool is_opened() const
+    {
+        return _base != nullptr;
+    }
+
+    int get_listen_fd() const
+    {
+        return _listen_fd;
+    }
+
+    uint64_t published() const
+    {
+        return _write_seq;
+    }
+
+    uint64_t dropped() const
+    {
+        return _dropped;
+    }
+
+    // readers currently asleep in next()
+    uint32_t waiters() const
+    {
+        return _waiters != nullptr ? _waiters->count.load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    int _memfd;
+    int _reader_fd;             // read-only reopen of _memfd, the one handed out
+    int _wait_fd;               // CShmWaiters, shared writable with readers
+    int _listen_fd;
+    void *_base;
+    long _size;
+    CShmWaiters *_waiters;
+    uint32_t _slot_count;
+    uint32_t _slot_size;
+
+    uint64_t _write_seq;
+    CShmSlot *_writing;
+    uint64_t _dropped;
+
+    CShmRingHeader *header() const
+    {
+        return (CShmRingHeader *)_base;
+    }
+};
+
+#endif
@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "shm_reader.h"
+#include "shm_futex.h"
+#include "../serial/timeout.h"
+
+CShmReader::~CShmReader()
+{
+    close();
+}
+
+int CShmReader::connect(const char *socket_path)
+{
+#ifdef DEBUG_SHM
+    fprintf(stderr, "[DEBUG] CShmReader::connect(\"%s\")\n", socket_path);
+#endif
+    sockaddr_un addr;
+    if (socket_path == nullptr || strlen(socket_path) >= sizeof(addr.sun_path)) {
+        return E_SHM_INVALID_ARG;
+    }
+    if (is_opened()) {
+        close();
+    }
+
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        return E_SHM_SOCKET_FAILED;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    if (::connect(sock, (sockaddr *)&addr, sizeof(addr)) < 0) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmReader::connect(...): E_SHM_SOCKET_FAILED\n"
+                        "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+#endif
+        ::close(sock);
+        return E_SHM_SOCKET_FAILED;
+    }
+
+    char byte;
+    iovec iov = { &byte, 1 };
+    union {
+        cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t ret = recvmsg(sock, &msg, MSG_CMSG_CLOEXEC);
+    ::close(sock);
+    cmsghdr *cmsg = ret == 1 ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmReader::connect(...): E_SHM_RECEIVE_FAILED\n");
+#endif
+        return E_SHM_RECEIVE_FAILED;
+    }
+    int fds[2];
+    const size_t nfds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    memcpy(fds, CMSG_DATA(cmsg), std::min(nfds, (size_t)2) * sizeof(int));
+    if (nfds != 2) {
+        // a version 1 publisher, which sends the ring alone
+        for (size_t i = 0; i < std::min(nfds, (size_t)2); ++i) {
+            ::close(fds[i]);
+        }
+        return E_SHM_BAD_FORMAT;
+    }
+    int fd = fds[0];
+    int wait_fd = fds[1];
+
+    struct stat st;
+    struct stat wait_st;
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(CShmRingHeader)
+        || fstat(wait_fd, &wait_st) < 0 || wait_st.st_size < (off_t)sizeof(CShmWaiters)) {
+        ::close(wait_fd);
+        ::close(fd);
+        return E_SHM_BAD_FORMAT;
+    }
+    void *base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        ::close(wait_fd);
+        ::close(fd);
+        return E_SHM_MAP_FAILED;
+    }
+    void *waiters = mmap(nullptr, sizeof(CShmWaiters), PROT_READ | PROT_WRITE, MAP_SHARED, wait_fd, 0);
+    if (waiters == MAP_FAILED) {
+        munmap(base, st.st_size);
+        ::close(wait_fd);
+        ::close(fd);
+        return E_SHM_MAP_FAILED;
+    }
+
+    auto *h = (const CShmRingHeader *)base;
+    const uint32_t slot_count = ((const volatile CShmRingHeader *)h)->slot_count;
+    const uint32_t slot_size = ((const volatile CShmRingHeader *)h)->slot_size;
+    if (h->magic != SHM_RING_MAGIC || h->version != SHM_RING_VERSION
+        || !shm_valid_geometry(slot_count, slot_size)
+        || shm_ring_size(slot_count, slot_size) > st.st_size) {
+#ifdef DEBUG_SHM
+        fprintf(stderr, "[DEBUG] CShmReader::connect(...): E_SHM_BAD_FORMAT\n");
+#endif
+        munmap(waiters, sizeof(CShmWaiters));
+        munmap(base, st.st_size);
+        ::close(wait_fd);
+        ::close(fd);
+        return E_SHM_BAD_FORMAT;
+    }
+
+    _fd = fd;
+    _wait_fd = wait_fd;
+    _base = base;
+    _size = st.st_size;
+    _waiters = (CShmWaiters *)waiters;
+    _slot_count = slot_count;
+    _slot_size = slot_size;
+    _lost = 0;
+
+    // begin with the oldest record still in the ring
+    uint64_t w = h->write_seq.load(std::memory_order_acquire);
+    _next = w > _slot_count ? w - _slot_count : 0;
+    return 0;
+}
+
+void CShmReader::close()
+{
+    if (_base != nullptr) {
+        munmap(_base, _size);
+        _base = nullptr;
+        _size = 0;
+    }
+    if (_waiters != nullptr) {
+        munmap(_waiters, sizeof(CShmWaiters));
+        _waiters = nullptr;
+    }
+    if (_wait_fd >= 0) {
+        ::close(_wait_fd);
+        _wait_fd = CLOSED;
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = CLOSED;
+    }
+}
+
+void CShmReader::seek_to_end()
+{
+    if (!is_opened()) {
+        return;
+    }
+    _next = header()->write_seq.load(std::memory_order_acquire);
+}
+
+CShmReadResult CShmReader::next(CShmRecord &rec, timeout_t timeout_msec)
+{
+    if (!is_opened()) {
+        return SHM_READ_ERROR;
+    }
+
+    const CShmRingHeader *h = header();
+    CTimeout timeout(timeout_msec);
+    while (true) {
+        uint32_t word = h->futex_word.load(std::memory_order_acquire);
+        uint64_t w = h->write_seq.load(std::memory_order_acquire);
+
+        while (_next < w) {
+            if (w - _next > _slot_count) {
+                _lost += w - _next - _slot_count;
+                _next = w - _slot_count;
+            }
+
+            const CShmSlot *slot = shm_slot_at(_base, _next, _slot_count, _slot_size);
+            uint64_t seq = slot->seq.load(std::memory_order_acquire);
+            if (seq != _next * 2 + 2) {
+                // lapped between reading write_seq and the slot
+                ++_lost;
+                ++_next;
+                continue;
+            }
+
+            rec.seq = _next;
+            rec.type = slot->type;
+            rec.length = slot->length;
+            rec.data = slot->data;
+            rec.slot = slot;
+            ++_next;
+            if (rec.length > shm_slot_capacity(_slot_size) || !validate(rec)) {
+                ++_lost;
+                continue;
+            }
+            return SHM_READ_OK;
+        }
+
+        if (timeout.is_expired()) {
+            return SHM_READ_TIMEOUT;
+        }
+        // counted before futex_word is looked at again, see commit()
+        _waiters->count.fetch_add(1, std::memory_order_seq_cst);
+        int ret = 0;
+        if (h->futex_word.load(std::memory_order_seq_cst) == word) {
+            ret = shm_futex_wait(&h->futex_word, word, timeout.time_left());
+        }
+        _waiters->count.fetch_sub(1, std::memory_order_release);
+        if (ret < 0 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT) {
+            return SHM_READ_ERROR;
+        }
+    }
+}
+
+bool CShmReader::validate(const CShmRecord &rec) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return rec.slot->seq.load(std::memory_order_relaxed) == rec.seq * 2 + 2;
+}
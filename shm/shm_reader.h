@@ -0,0 +1,89 @@
+#ifndef _SHM_READER_H_
+#define _SHM_READER_H_
+
+#include <cstdint>
+
+#include "shm_ring.h"
+
+// points straight into the shared mapping
+struct CShmRecord
+{
+    uint64_t seq;
+    uint16_t type;
+    uint32_t length;
+    const uint8_t *data;
+    const CShmSlot *slot;
+};
+
+/*
+  consumer side of the ring.
+
+      CShmReader reader;
+      reader.connect("/tmp/raspi-echonet.sock");
+      CShmRecord rec;
+      while (reader.next(rec, 1000) != SHM_READ_ERROR) {
+          ... use rec.data ...
+          if (!reader.validate(rec)) { ... the writer lapped us, discard ... }
+      }
+
+  every reader keeps its own position. a reader which falls more than
+  slot_count records behind skips ahead; the skipped count is in lost().
+ */
+class CShmReader
+{
+public:
+    using timeout_t = long;
+    const int CLOSED = -1;
+    const timeout_t INFINITE = -1;
+
+    CShmReader()
+        : _fd(CLOSED), _wait_fd(CLOSED), _base(nullptr), _size(0), _waiters(nullptr), _slot_count(0),
+          _slot_size(0), _next(0), _lost(0)
+    {
+    }
+
+    ~CShmReader();
+
+    int connect(const char *socket_path);
+
+    void close();
+
+    // start from the next record published instead of the oldest one kept
+    void seek_to_end();
+
+    CShmReadResult next(CShmRecord &rec, timeout_t timeout_msec);
+
+    // true if rec was not overwritten while it was being used
+    bool validate(const CShmRecord &rec) const;
+
+    bool is_opened() const
+    {
+        return _base != nullptr;
+    }
+
+    uint64_t lost() const
+    {
+        return _lost;
+    }
+
+private:
+    int _fd;
+    int _wait_fd;
+    void *_base;
+    long _size;
+    CShmWaiters *_waiters;      // the only shared memory a reader writes
+
+    // checked once in connect(), the shared header is not trusted after that
+    uint32_t _slot_count;
+    uint32_t _slot_size;
+
+    uint64_t _next;
+    uint64_t _lost;
+
+    const CShmRingHeader *header() const
+    {
+        return (const CShmRingHeader *)_base;
+    }
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef _SHM_RECORDS_H_
+#define _SHM_RECORDS_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include "shm_publisher.h"
+#include "../event/skevents.h"
+
+/*
+  record layouts in the ring. CShmSlot::type holds the CEventType and the
+  data is one of the structs below, so consumers read the fields in place.
+ */
+
+struct CShmRxUdp
+{
+    uint8_t sender[16];
+    uint16_t rport;
+    uint16_t lport;
+    uint8_t secured;
+    uint8_t reserved;
+    uint16_t length;
+    uint8_t data[];
+};
+
+struct CShmSkEvent
+{
+    uint8_t sender[16];
+    uint8_t num;
+    uint8_t has_param;
+    uint8_t param;
+    uint8_t reserved;
+};
+
+struct CShmResponse
+{
+    uint8_t ok;
+    uint8_t has_value;
+    uint8_t value;      // OK value or FAIL error number
+    uint8_t reserved;
+};
+
+inline int shm_publish(CShmPublisher &publisher, const CEvERXUDP &ev)
+{
+    const auto &data = ev.data();
+    auto *rec = (CShmRxUdp *)publisher.begin(EVT_ERXUDP, sizeof(CShmRxUdp) + data.size());
+    if (rec == nullptr) {
+        return E_SHM_INVALID_ARG;
+    }
+    memcpy(rec->sender, ev.sender().data(), sizeof(rec->sender));
+    rec->rport = ev.rport();
+    rec->lport = ev.lport();
+    rec->secured = ev.secured();
+    rec->reserved = 0;
+    rec->length = data.size();
+    memcpy(rec->data, data.data(), data.size());
+    publisher.commit();
+    return 0;
+}
+
+inline int shm_publish(CShmPublisher &publisher, const CEvEVENT &ev)
+{
+    CShmSkEvent rec;
+    memcpy(rec.sender, ev.sender().data(), sizeof(rec.sender));
+    rec.num = ev.num();
+    rec.has_param = ev.param().has_value();
+    rec.param = ev.param().value_or(0);
+    rec.reserved = 0;
+    return publisher.publish(EVT_EVENT, &rec, sizeof(rec));
+}
+
+inline int shm_publish(CShmPublisher &publisher, const CEventBase &ev)
+{
+    switch (ev.get_type()) {
+    case EVT_ERXUDP:
+        return shm_publish(publisher, static_cast<const CEvERXUDP &>(ev));
+    case EVT_EVENT:
+        return shm_publish(publisher, static_cast<const CEvEVENT &>(ev));
+    case EVT_OK: {
+        const auto &ok = static_cast<const CEvOK &>(ev);
+        CShmResponse rec = { 1, ok.value().has_value(), ok.value().value_or(0), 0 };
+        return publisher.publish(EVT_OK, &rec, sizeof(rec));
+    }
+    case EVT_FAIL: {
+        const auto &fail = static_cast<const CEvFAIL &>(ev);
+        CShmResponse rec = { 0, 1, fail.error(), 0 };
+        return publisher.publish(EVT_FAIL, &rec, sizeof(rec));
+    }
+    default:
+        // scan results and tables stay local to the gateway
+        return 0;
+    }
+}
+
+#endif
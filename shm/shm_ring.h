@@ -0,0 +1,93 @@
+#ifndef _SHM_RING_H_
+#define _SHM_RING_H_
+
+#include <atomic>
+#include <cstdint>
+
+/*
+  layout of the shared-memory ring.
+
+  one writer (the gateway) and any number of readers. message n lives in
+  slot n % slot_count. each slot is guarded by its own sequence word:
+  2n+1 while message n is being written, 2n+2 once it is complete. a
+  reader which finds a larger value knows it has been lapped (overrun).
+  futex_word is bumped after every publish and is what readers sleep on.
+
+  readers map the ring read-only, so the count of readers asleep on
+  futex_word lives in a second, one-line memfd (CShmWaiters) which they
+  map writable. the writer skips FUTEX_WAKE while it is zero. a reader
+  which miscounts only delays the others' wake-ups, it cannot touch data.
+ */
+
+enum CShmError {
+    E_SHM_INVALID_ARG     = -1,
+    E_SHM_NOT_OPENED      = -2,
+    E_SHM_CREATE_FAILED   = -10,
+    E_SHM_MAP_FAILED      = -11,
+    E_SHM_SOCKET_FAILED   = -12,
+    E_SHM_RECEIVE_FAILED  = -13,
+    E_SHM_BAD_FORMAT      = -14,
+};
+
+enum CShmReadResult {
+    SHM_READ_OK,
+    SHM_READ_TIMEOUT,
+    SHM_READ_ERROR,
+};
+
+constexpr uint32_t SHM_RING_MAGIC = 0x45434E52;  // "RNCE"
+constexpr uint32_t SHM_RING_VERSION = 2;
+
+struct CShmRingHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_count;        // power of two
+    uint32_t slot_size;         // bytes, including CShmSlot
+    alignas(64) std::atomic<uint64_t> write_seq;    // next message number
+    alignas(64) std::atomic<uint32_t> futex_word;
+};
+
+struct CShmWaiters
+{
+    alignas(64) std::atomic<uint32_t> count;
+};
+
+struct CShmSlot
+{
+    std::atomic<uint64_t> seq;
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t length;
+    alignas(8) uint8_t data[];
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t), "atomic must be address-free");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "atomic must be lock-free to be shared");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "atomic must be lock-free to be shared");
+
+inline constexpr long shm_ring_size(uint32_t slot_count, uint32_t slot_size)
+{
+    return (long)sizeof(CShmRingHeader) + (long)slot_count * slot_size;
+}
+
+// geometry comes from the caller's own validated copy, never from the
+// shared header, which consumers must not be able to steer
+inline CShmSlot *shm_slot_at(void *base, uint64_t n, uint32_t slot_count, uint32_t slot_size)
+{
+    uint8_t *slots = (uint8_t *)base + sizeof(CShmRingHeader);
+    return (CShmSlot *)(slots + (n & (slot_count - 1)) * slot_size);
+}
+
+inline uint32_t shm_slot_capacity(uint32_t slot_size)
+{
+    return slot_size - sizeof(CShmSlot);
+}
+
+inline bool shm_valid_geometry(uint32_t slot_count, uint32_t slot_size)
+{
+    return slot_count != 0 && (slot_count & (slot_count - 1)) == 0
+        && slot_size > sizeof(CShmSlot) && slot_size % alignof(CShmSlot) == 0;
+}
+
+#endif
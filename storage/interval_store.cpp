@@ -0,0 +1,141 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "interval_store.h"
+
+CFileIntervalStore::~CFileIntervalStore()
+{
+    close();
+}
+
+int CFileIntervalStore::open(const char *path)
+{
+#ifdef DEBUG_STORE
+    fprintf(stderr, "[DEBUG] CFileIntervalStore::open(\"%s\")\n", path);
+#endif
+    if (path == nullptr) {
+        return E_STORE_INVALID_ARG;
+    }
+    if (is_opened()) {
+        close();
+    }
+
+    int fd = ::open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+#ifdef DEBUG_STORE
+        fprintf(stderr, "[DEBUG] CFileIntervalStore::open(...): E_STORE_OPEN_FAILED\n"
+                        "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+#endif
+        return E_STORE_OPEN_FAILED;
+    }
+
+    _records.clear();
+    CIntervalRecord chunk[256];
+    while (true) {
+        ssize_t ret = ::read(fd, chunk, sizeof(chunk));
+        if (ret <= 0) {
+            break;
+        }
+        // a torn record at the end of the file is ignored
+        for (size_t i = 0; i < (size_t)ret / sizeof(CIntervalRecord); ++i) {
+            _records[chunk[i].time] = chunk[i];
+        }
+    }
+
+    _fd = fd;
+#ifdef DEBUG_STORE
+    fprintf(stderr, "[DEBUG] CFileIntervalStore::open(...): %zu slots\n", _records.size());
+#endif
+    return 0;
+}
+
+void CFileIntervalStore::close()
+{
+    if (!is_opened()) {
+        return;
+    }
+    ::close(_fd);
+    _fd = CLOSED;
+    _records.clear();
+}
+
+void CFileIntervalStore::find_gaps(int64_t from, int64_t to, gap_list &out) const
+{
+    out.clear();
+    from -= from % SLOT_SECONDS;
+
+    int64_t gap_begin = -1;
+    auto it = _records.lower_bound(from);
+    for (int64_t t = from; t < to; t += SLOT_SECONDS) {
+        while (it != _records.end() && it->first < t) {
+            ++it;
+        }
+        bool known = it != _records.end() && it->first == t && it->second.normal != CIntervalRecord::NO_DATA;
+        if (!known && gap_begin < 0) {
+            gap_begin = t;
+        } else if (known && gap_begin >= 0) {
+            out.emplace_back(gap_begin, t);
+            gap_begin = -1;
+        }
+    }
+    if (gap_begin >= 0) {
+        out.emplace_back(gap_begin, to);
+    }
+}
+
+int CFileIntervalStore::insert_bulk(const CIntervalRecord *records, size_t count)
+{
+    if (!is_opened()) {
+        return E_STORE_NOT_OPENED;
+    }
+    if (records == nullptr && count > 0) {
+        return E_STORE_INVALID_ARG;
+    }
+
+    _changed.clear();
+    for (size_t i = 0; i < count; ++i) {
+        const CIntervalRecord &in = records[i];
+        if (in.time % SLOT_SECONDS != 0) {
+            continue;
+        }
+        auto result = _records.emplace(in.time, in);
+        CIntervalRecord &cur = result.first->second;
+        bool changed = result.second;
+        if (!changed) {
+            if (in.normal != CIntervalRecord::NO_DATA && in.normal != cur.normal) {
+                cur.normal = in.normal;
+                changed = true;
+            }
+            if (in.reverse != CIntervalRecord::NO_DATA && in.reverse != cur.reverse) {
+                cur.reverse = in.reverse;
+                changed = true;
+            }
+        }
+        if (changed) {
+            _changed.push_back(cur);
+        }
+    }
+
+    // one write per batch
+    const char *p = (const char *)_changed.data();
+    size_t left = _changed.size() * sizeof(CIntervalRecord);
+    while (left > 0) {
+        ssize_t ret = ::write(_fd, p, left);
+        if (ret < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+#ifdef DEBUG_STORE
+            fprintf(stderr, "[DEBUG] CFileIntervalStore::insert_bulk(...): E_STORE_WRITE_FAILED\n"
+                            "        errno=%d, msg=\"%s\"\n", errno, strerror(errno));
+#endif
+            return E_STORE_WRITE_FAILED;
+        }
+        p += ret;
+        left -= ret;
+    }
+    return (int)_changed.size();
+}
@@ -0,0 +1,89 @@
+#ifndef _STORAGE_INTERVAL_STORE_H_
+#define _STORAGE_INTERVAL_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+enum CStoreError {
+    E_STORE_INVALID_ARG   = -1,
+    E_STORE_NOT_OPENED    = -2,
+    E_STORE_OPEN_FAILED   = -10,
+    E_STORE_WRITE_FAILED  = -11,
+};
+
+// cumulative energy at the end of one 30 minute slot, as the meter counts it
+struct CIntervalRecord
+{
+    static constexpr uint32_t NO_DATA = 0xFFFFFFFE;
+
+    int64_t time;           // epoch seconds, multiple of SLOT_SECONDS
+    uint32_t normal;
+    uint32_t reverse;
+};
+
+static_assert(sizeof(CIntervalRecord) == 16, "on-disk layout");
+
+/*
+  30 minute cumulative energy series of one meter.
+ */
+class CIntervalStore
+{
+public:
+    using gap_list = std::vector<std::pair<int64_t, int64_t>>;
+
+    static constexpr int64_t SLOT_SECONDS = 30 * 60;
+
+    virtual ~CIntervalStore() = default;
+
+    // [begin, end) ranges of slots in [from, to) without a normal direction value
+    virtual void find_gaps(int64_t from, int64_t to, gap_list &out) const = 0;
+
+    // merges records, NO_DATA never overwrites a known value.
+    // returns the number of slots which changed or a CStoreError
+    virtual int insert_bulk(const CIntervalRecord *records, size_t count) = 0;
+};
+
+/*
+  append-only file of CIntervalRecord, indexed in memory.
+  a later record for the same slot replaces an earlier one on load.
+ */
+class CFileIntervalStore : public CIntervalStore
+{
+public:
+    const int CLOSED = -1;
+
+    CFileIntervalStore()
+        : _fd(CLOSED)
+    {
+    }
+
+    ~CFileIntervalStore();
+
+    int open(const char *path);
+
+    void close();
+
+    void find_gaps(int64_t from, int64_t to, gap_list &out) const override;
+
+    int insert_bulk(const CIntervalRecord *records, size_t count) override;
+
+    bool is_opened() const
+    {
+        return _fd >= 0;
+    }
+
+    size_t size() const
+    {
+        return _records.size();
+    }
+
+private:
+    int _fd;
+    std::map<int64_t, CIntervalRecord> _records;
+    std::vector<CIntervalRecord> _changed;
+};
+
+#endif
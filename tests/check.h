@@ -0,0 +1,36 @@
+#ifndef _TESTS_CHECK_H_
+#define _TESTS_CHECK_H_
+
+#include <stdio.h>
+
+/*
+  the tests are plain executables run by ctest: every CHECK which fails
+  is printed and counted, and main() returns check_result().
+ */
+inline int check_failures = 0;
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++check_failures; \
+        } \
+    } while (0)
+
+// a failure which is not a condition, e.g. the test setup itself failed
+#define CHECK_FAIL(what) \
+    do { \
+        fprintf(stderr, "%s:%d: %s\n", __FILE__, __LINE__, what); \
+        ++check_failures; \
+    } while (0)
+
+inline int check_result()
+{
+    if (check_failures != 0) {
+        fprintf(stderr, "%d check(s) failed\n", check_failures);
+        return 1;
+    }
+    return 0;
+}
+
+#endif
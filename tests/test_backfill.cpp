@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+
+#include "../echonet/backfill.h"
+#include "check.h"
+
+namespace {
+
+const int64_t SLOT = CIntervalStore::SLOT_SECONDS;
+const int64_t DAY = 24 * 60 * 60;
+const uint32_t NO_DATA = CIntervalRecord::NO_DATA;
+
+// everything asked for is a gap, inserts are kept for the checks
+class CMemoryStore : public CIntervalStore
+{
+public:
+    std::vector<CIntervalRecord> records;
+
+    void find_gaps(int64_t from, int64_t to, gap_list &out) const override
+    {
+        out.push_back({ from, to });
+    }
+
+    int insert_bulk(const CIntervalRecord *r, size_t count) override
+    {
+        records.insert(records.end(), r, r + count);
+        return (int)count;
+    }
+};
+
+struct CMeter
+{
+    node_addr_t node {};
+    CPropertyCache cache;
+    std::vector<std::vector<uint8_t>> sent;
+    CEchonetRequester requester;
+
+    CMeter()
+        : requester(cache, [this](const node_addr_t &, const std::vector<uint8_t> &frame) {
+              sent.push_back(frame);
+              return SEND_OK;
+          })
+    {
+        node[0] = 0xFE;
+        node[1] = 0x80;
+    }
+
+    // answers sent[index] with the given ESV and properties
+    bool respond(size_t index, uint8_t esv, const std::vector<std::pair<uint8_t, std::vector<uint8_t>>> &props)
+    {
+        const auto &req = sent[index];
+        std::vector<uint8_t> frame = { 0x10, 0x81, req[2], req[3], 0x02, 0x88, 0x01, 0x05, 0xFF, 0x01, esv,
+                                       (uint8_t)props.size() };
+        for (const auto &prop : props) {
+            frame.push_back(prop.first);
+            frame.push_back((uint8_t)prop.second.size());
+            frame.insert(frame.end(), prop.second.begin(), prop.second.end());
+        }
+        return requester.handle(node, frame, 0);
+    }
+};
+
+void put32(std::vector<uint8_t> &out, uint32_t v)
+{
+    out.push_back((uint8_t)(v >> 24));
+    out.push_back((uint8_t)(v >> 16));
+    out.push_back((uint8_t)(v >> 8));
+    out.push_back((uint8_t)v);
+}
+
+// E2/E4: day(2) + 48 x cumulative(4)
+std::vector<uint8_t> day_history(int day, uint32_t base, int skip)
+{
+    std::vector<uint8_t> edt = { (uint8_t)(day >> 8), (uint8_t)day };
+    for (int i = 0; i < 48; ++i) {
+        put32(edt, i == skip ? NO_DATA : base + i);
+    }
+    return edt;
+}
+
+}
+
+static void test_day_history(int64_t midnight)
+{
+    CMeter meter;
+    CMemoryStore store;
+    CBackfillJob job(meter.requester, store, meter.node, BACKFILL_DAY_HISTORY, true, 1);
+
+    // yesterday only, today has not ended a slot yet
+    CHECK(job.plan(midnight - DAY, midnight, midnight + 60) == 1);
+    job.run(0);
+    CHECK(meter.sent.size() == 2);
+    if (meter.sent.size() != 2) {
+        return;
+    }
+
+    // SetC E5=1 then Get E2 E4
+    const auto &select = meter.sent[0];
+    CHECK(select.size() == 15 && select[10] == ESV_SETC && select[11] == 1);
+    CHECK(select[12] == EPC_HISTORY_DAY && select[13] == 1 && select[14] == 1);
+    const auto &read = meter.sent[1];
+    CHECK(read.size() == 16 && read[10] == ESV_GET && read[11] == 2);
+    CHECK(read[12] == EPC_HISTORY_NORMAL && read[14] == EPC_HISTORY_REVERSE);
+
+    // an answer for another day is sent again
+    meter.respond(0, ESV_SET_RES, { { EPC_HISTORY_DAY, {} } });
+    meter.respond(1, ESV_GET_RES, { { EPC_HISTORY_NORMAL, day_history(2, 1000, -1) },
+                                    { EPC_HISTORY_REVERSE, day_history(2, 5000, -1) } });
+    CHECK(store.records.empty());
+    job.run(0);
+    CHECK(meter.sent.size() == 4);
+    if (meter.sent.size() != 4) {
+        return;
+    }
+
+    // slot 3 unknown in both directions, slot 7 only in reverse
+    auto normal = day_history(1, 1000, 3);
+    auto reverse = day_history(1, 5000, 3);
+    for (int i = 0; i < 4; ++i) {
+        normal[2 + 7 * 4 + i] = 0xFF;
+    }
+    normal[2 + 7 * 4 + 3] = 0xFE;
+    meter.respond(2, ESV_SET_RES, { { EPC_HISTORY_DAY, {} } });
+    meter.respond(3, ESV_GET_RES, { { EPC_HISTORY_NORMAL, normal }, { EPC_HISTORY_REVERSE, reverse } });
+
+    CHECK(job.done());
+    CHECK(job.inserted() == 47);
+    CHECK(store.records.size() == 47);
+    if (store.records.size() != 47) {
+        return;
+    }
+    CHECK(store.records[0].time == midnight - DAY);
+    CHECK(store.records[0].normal == 1000 && store.records[0].reverse == 5000);
+    CHECK(store.records[3].time == midnight - DAY + 4 * SLOT);
+    CHECK(store.records[3].normal == 1004);
+    CHECK(store.records[6].time == midnight - DAY + 7 * SLOT);
+    CHECK(store.records[6].normal == NO_DATA && store.records[6].reverse == 5007);
+    CHECK(store.records[46].time == midnight - SLOT);
+    CHECK(store.records[46].normal == 1047 && store.records[46].reverse == 5047);
+}
+
+static void test_time_history(int64_t midnight)
+{
+    CMeter meter;
+    CMemoryStore store;
+    CBackfillJob job(meter.requester, store, meter.node, BACKFILL_TIME_HISTORY, true, 1);
+
+    // the last three slots of yesterday: newest 23:30, three points
+    CHECK(job.plan(midnight - 3 * SLOT, midnight, midnight + 60) == 1);
+    job.run(0);
+    CHECK(meter.sent.size() == 2);
+    if (meter.sent.size() != 2) {
+        return;
+    }
+
+    time_t tt = (time_t)(midnight - SLOT);
+    struct tm tm;
+    localtime_r(&tt, &tm);
+    const int year = tm.tm_year + 1900;
+    const std::vector<uint8_t> selection = { (uint8_t)(year >> 8), (uint8_t)year, (uint8_t)(tm.tm_mon + 1),
+                                             (uint8_t)tm.tm_mday, 23, 30, 3 };
+
+    const auto &select = meter.sent[0];
+    CHECK(select.size() == 21 && select[10] == ESV_SETC && select[12] == EPC_HISTORY2_TIME && select[13] == 7);
+    CHECK(select.size() == 21 && std::vector<uint8_t>(select.begin() + 14, select.end()) == selection);
+    const auto &read = meter.sent[1];
+    CHECK(read.size() == 14 && read[10] == ESV_GET && read[12] == EPC_HISTORY2);
+
+    // EC: the selection echoed, then newest first (normal(4), reverse(4)) per point
+    std::vector<uint8_t> edt = selection;
+    put32(edt, 300);
+    put32(edt, 30);
+    put32(edt, NO_DATA);
+    put32(edt, NO_DATA);
+    put32(edt, 100);
+    put32(edt, 10);
+    meter.respond(0, ESV_SET_RES, { { EPC_HISTORY2_TIME, {} } });
+    meter.respond(1, ESV_GET_RES, { { EPC_HISTORY2, edt } });
+
+    CHECK(job.done());
+    CHECK(store.records.size() == 2);
+    if (store.records.size() != 2) {
+        return;
+    }
+    CHECK(store.records[0].time == midnight - SLOT);
+    CHECK(store.records[0].normal == 300 && store.records[0].reverse == 30);
+    CHECK(store.records[1].time == midnight - 3 * SLOT);
+    CHECK(store.records[1].normal == 100 && store.records[1].reverse == 10);
+}
+
+// EA/EB: YYYY MM DD hh mm ss + cumulative(4)
+static std::vector<uint8_t> fixed_time(int64_t t, uint32_t value)
+{
+    time_t tt = (time_t)t;
+    struct tm tm;
+    localtime_r(&tt, &tm);
+    const int year = tm.tm_year + 1900;
+    std::vector<uint8_t> edt = { (uint8_t)(year >> 8), (uint8_t)year, (uint8_t)(tm.tm_mon + 1), (uint8_t)tm.tm_mday,
+                                 (uint8_t)tm.tm_hour, (uint8_t)tm.tm_min, (uint8_t)tm.tm_sec };
+    put32(edt, value);
+    return edt;
+}
+
+static void test_fixed_time(int64_t midnight)
+{
+    CMemoryStore store;
+    const int64_t slot = midnight + 21 * SLOT;
+
+    auto normal = fixed_time(slot, 1234);
+    CHECK(store_fixed_time_reading(store, EPC_FIXED_TIME_NORMAL, normal.data(), (uint8_t)normal.size()) == 1);
+    auto reverse = fixed_time(slot, 56);
+    CHECK(store_fixed_time_reading(store, EPC_FIXED_TIME_REVERSE, reverse.data(), (uint8_t)reverse.size()) == 1);
+    CHECK(store.records.size() == 2);
+    if (store.records.size() != 2) {
+        return;
+    }
+    CHECK(store.records[0].time == slot && store.records[0].normal == 1234 && store.records[0].reverse == NO_DATA);
+    CHECK(store.records[1].time == slot && store.records[1].normal == NO_DATA && store.records[1].reverse == 56);
+
+    // not a slot boundary, the wrong EPC or length, or no value: nothing is stored
+    auto off = fixed_time(slot + 60, 1234);
+    CHECK(store_fixed_time_reading(store, EPC_FIXED_TIME_NORMAL, off.data(), (uint8_t)off.size()) == E_STORE_INVALID_ARG);
+    CHECK(store_fixed_time_reading(store, EPC_CUMULATIVE_NORMAL, normal.data(), (uint8_t)normal.size()) == E_STORE_INVALID_ARG);
+    CHECK(store_fixed_time_reading(store, EPC_FIXED_TIME_NORMAL, normal.data(), 10) == E_STORE_INVALID_ARG);
+    auto unknown = fixed_time(slot, NO_DATA);
+    CHECK(store_fixed_time_reading(store, EPC_FIXED_TIME_NORMAL, unknown.data(), (uint8_t)unknown.size()) == 0);
+    CHECK(store.records.size() == 2);
+}
+
+int main()
+{
+    // the meter counts in local time, pin it
+    setenv("TZ", "UTC", 1);
+    tzset();
+    const int64_t midnight = 1760000000 - 1760000000 % DAY;
+
+    test_day_history(midnight);
+    test_time_history(midnight);
+    test_fixed_time(midnight);
+    return check_result();
+}
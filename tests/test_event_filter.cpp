@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../event/skevents.h"
+#include "check.h"
+
+namespace {
+
+const char SENDER[] = "FE80:0000:0000:0000:021C:6400:030C:12A4";
+
+// Get_Res from the smart meter: E7 = 300 W
+std::string erxudp(uint16_t lport, const char *sender = SENDER)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "ERXUDP %s FE80:0000:0000:0000:021D:1290:1234:5678 0E1A %04X 001C6400030C12A4 1 "
+             "0012 1081000102880105FF017201E7040000012C\r\n", sender, lport);
+    return line;
+}
+
+const char EPANDESC[] =
+    "EPANDESC\r\n"
+    "  Channel:21\r\n"
+    "  Channel Page:09\r\n"
+    "  Pan ID:8888\r\n"
+    "  Addr:12345678ABCDEF01\r\n"
+    "  LQI:E1\r\n";
+
+const char ENEIGHBOR[] =
+    "ENEIGHBOR\r\n"
+    "FE80:0000:0000:0000:021C:6400:030C:12A4 001C6400030C12A4\r\n"
+    "FE80:0000:0000:0000:021C:6400:030C:12A5 001C6400030C12A5\r\n";
+
+// every result the dispatcher gives for buf, the events' types for EV_MATCHED
+std::vector<int> run(CEventFilter &filter, const std::string &in, std::vector<CEventType> &types)
+{
+    std::vector<char> buf(in.begin(), in.end());
+    std::vector<int> results;
+    long pos = 0;
+    while (pos < (long)buf.size()) {
+        CSkEventDispatcher::ptr_type ev;
+        long next_pos = pos;
+        auto result = CSkEventDispatcher::parse(buf, pos, buf.size() - pos, ev, next_pos, &filter);
+        results.push_back(result);
+        if (result == EV_SHORT_LENGTH || result == EV_ERROR) {
+            break;
+        }
+        if (result == EV_MATCHED) {
+            types.push_back(ev->get_type());
+        }
+        pos = next_pos;
+    }
+    return results;
+}
+
+}
+
+// the columns the filter reads come from the schema, they must be where SKSTACK prints them
+static void test_offsets()
+{
+    const std::string line = erxudp(0x0E1A);
+    CHECK(line.compare(CEvERXUDP::offset_of<f_sender>(), 39, SENDER) == 0);
+    CHECK(line.compare(CEvERXUDP::offset_of<f_dest>(), 4, "FE80") == 0);
+    CHECK(line.compare(CEvERXUDP::offset_of<f_rport>() - 1, 6, " 0E1A ") == 0);
+    CHECK(line.compare(CEvERXUDP::offset_of<f_lport>() - 1, 6, " 0E1A ") == 0);
+    CHECK(line.compare(CEvERXUDP::offset_of<f_senderlla>(), 16, "001C6400030C12A4") == 0);
+    CHECK(line.compare(CEvERXUDP::offset_of<f_secured>() - 1, 3, " 1 ") == 0);
+    CHECK(line.compare(CEvERXUDP::offset_of<f_data>(), 5, "0012 ") == 0);
+    CHECK(line.compare(CEvERXUDP::offset_of<f_data>() + sk_payload<>::header_width, 4, "1081") == 0);
+}
+
+static void test_header_and_payload()
+{
+    CEventFilter filter;
+    CSubscription echonet;
+    echonet.types = CSubscription::type_bit(EVT_ERXUDP);
+    echonet.lport = 0x0E1A;
+    filter.subscribe(echonet);
+
+    // PANA (716) is dropped on the port
+    std::vector<CEventType> types;
+    auto results = run(filter, erxudp(0x02CC) + erxudp(0x0E1A), types);
+    CHECK(results.size() == 2 && results[0] == EV_FILTERED && results[1] == EV_MATCHED);
+    CHECK(types.size() == 1 && types[0] == EVT_ERXUDP);
+    CHECK(filter.get_stats().dropped[FILTER_HEADER] == 1);
+    CHECK(filter.get_stats().passed == 1);
+
+    // a sender and an EPC, read from the DATA
+    CEventFilter by_payload;
+    CSubscription meter;
+    meter.sender = sk_ipv6::value_type { 0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x1C, 0x64, 0x00, 0x03, 0x0C, 0x12, 0xA4 };
+    meter.epc = 0xE7;
+    by_payload.subscribe(meter);
+    types.clear();
+    results = run(by_payload, erxudp(0x0E1A, "FE80:0000:0000:0000:021C:6400:030C:12A5") + erxudp(0x0E1A), types);
+    CHECK(results.size() == 2 && results[0] == EV_FILTERED && results[1] == EV_MATCHED);
+
+    meter.epc = 0xE0;
+    CEventFilter other_epc;
+    other_epc.subscribe(meter);
+    types.clear();
+    results = run(other_epc, erxudp(0x0E1A), types);
+    CHECK(results.size() == 1 && results[0] == EV_FILTERED);
+    CHECK(other_epc.get_stats().dropped[FILTER_PAYLOAD] == 1);
+}
+
+// events dropped on their type are skipped whole, continuation lines included
+static void test_multiline_drop()
+{
+    CEventFilter filter;
+    CSubscription echonet;
+    echonet.types = CSubscription::type_bit(EVT_ERXUDP);
+    filter.subscribe(echonet);
+
+    std::vector<CEventType> types;
+    auto results = run(filter, std::string(EPANDESC) + ENEIGHBOR + erxudp(0x0E1A), types);
+    CHECK(results.size() == 3);
+    CHECK(results.size() == 3 && results[0] == EV_FILTERED && results[1] == EV_FILTERED && results[2] == EV_MATCHED);
+    CHECK(types.size() == 1 && types[0] == EVT_ERXUDP);
+    CHECK(filter.get_stats().dropped[FILTER_TYPE] == 2);
+
+    // the end of a dropped EPANDESC is only known once the next line starts
+    types.clear();
+    const std::string partial(EPANDESC, strlen(EPANDESC) - 4);
+    results = run(filter, partial, types);
+    CHECK(results.size() == 1 && results[0] == EV_SHORT_LENGTH);
+}
+
+int main()
+{
+    test_offsets();
+    test_header_and_payload();
+    test_multiline_drop();
+    return check_result();
+}
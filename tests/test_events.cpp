@@ -0,0 +1,131 @@
+#include <pty.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../event/skevents.h"
+#include "../event/event_reader.h"
+#include "check.h"
+
+static std::vector<char> to_buf(const std::string &s)
+{
+    return std::vector<char>(s.begin(), s.end());
+}
+
+static const char erxudp[] =
+    "ERXUDP FE80:0000:0000:0000:021C:6400:030C:12A4 FE80:0000:0000:0000:021D:1290:1234:5678 "
+    "0E1A 0E1A 001C6400030C12A4 1 0012 1081000102880105FF017201E70400000370\r\n";
+
+static const char epandesc[] =
+    "EPANDESC\r\n"
+    "  Channel:21\r\n"
+    "  Channel Page:09\r\n"
+    "  Pan ID:8888\r\n"
+    "  Addr:12345678ABCDEF01\r\n"
+    "  LQI:E1\r\n"
+    "  PairID:00112233\r\n";
+
+static void test_erxudp()
+{
+    auto buf = to_buf(erxudp);
+    CSkEventDispatcher::ptr_type ev;
+    long next_pos = 0;
+    CHECK(CSkEventDispatcher::parse(buf, 0, buf.size(), ev, next_pos) == EV_MATCHED);
+    CHECK(next_pos == (long)buf.size());
+
+    auto *rx = dynamic_cast<CEvERXUDP *>(ev.get());
+    CHECK(rx != nullptr);
+    if (rx == nullptr) {
+        return;
+    }
+    CHECK(rx->sender()[0] == 0xFE && rx->sender()[15] == 0xA4);
+    CHECK(rx->dest()[8] == 0x02 && rx->dest()[15] == 0x78);
+    CHECK(rx->rport() == 0x0E1A);
+    CHECK(rx->lport() == 0x0E1A);
+    CHECK(rx->senderlla() == 0x001C6400030C12A4ULL);
+    CHECK(rx->secured());
+    CHECK(rx->data().size() == 0x12);
+    CHECK(rx->data()[0] == 0x10 && rx->data()[1] == 0x81 && rx->data()[17] == 0x70);
+
+    // every split point needs more data, none of them is a different event
+    for (size_t len = 1; len < buf.size(); ++len) {
+        long pos = 0;
+        CHECK(CSkEventDispatcher::parse(buf, 0, len, ev, pos) == EV_SHORT_LENGTH);
+    }
+}
+
+static void test_epandesc()
+{
+    auto buf = to_buf(epandesc);
+    CSkEventDispatcher::ptr_type ev;
+    long next_pos = 0;
+    CHECK(CSkEventDispatcher::parse(buf, 0, buf.size(), ev, next_pos) == EV_MATCHED);
+    CHECK(next_pos == (long)buf.size());
+
+    auto *desc = dynamic_cast<CEvEPANDESC *>(ev.get());
+    CHECK(desc != nullptr);
+    if (desc == nullptr) {
+        return;
+    }
+    CHECK(desc->channel() == 0x21);
+    CHECK(desc->channel_page() == 0x09);
+    CHECK(desc->pan_id() == 0x8888);
+    CHECK(desc->addr() == 0x12345678ABCDEF01ULL);
+    CHECK(desc->lqi() == 0xE1);
+    CHECK(desc->pair_id().has_value() && *desc->pair_id() == 0x00112233);
+
+    // without PairID the event ends after LQI, once the next line shows it
+    std::string no_pair(epandesc, strstr(epandesc, "  PairID") - epandesc);
+    buf = to_buf(no_pair + "OK\r\n");
+    CHECK(CSkEventDispatcher::parse(buf, 0, buf.size(), ev, next_pos) == EV_MATCHED);
+    CHECK(next_pos == (long)no_pair.size());
+    desc = dynamic_cast<CEvEPANDESC *>(ev.get());
+    CHECK(desc != nullptr && !desc->pair_id().has_value());
+}
+
+// overlong lines are dropped up to the CRLF and the events after them survive
+static void test_reader_overflow()
+{
+    int master, slave;
+    char name[64];
+    if (openpty(&master, &slave, name, nullptr, nullptr) < 0) {
+        CHECK_FAIL("openpty failed");
+        return;
+    }
+    CSerial serial;
+    CHECK(serial.open(name, B115200) == 0);
+    serial.set_timeout(100);
+
+    CEventReader<CSkEventDispatcher> reader(64, 256);
+    std::string noise(1000, 'X');
+    std::string in = "OK\r\n" + noise + "\r\n" + erxudp;
+    CHECK(write(master, in.data(), in.size()) == (ssize_t)in.size());
+
+    std::vector<int> types;
+    CSkEventDispatcher::ptr_type ev;
+    for (int i = 0; i < 200 && types.size() < 2; ++i) {
+        if (reader.read_from(serial) <= 0) {
+            break;
+        }
+        while (reader.next(ev) == EV_MATCHED) {
+            types.push_back(ev->get_type());
+        }
+    }
+    CHECK(types.size() == 2);
+    CHECK(types.size() == 2 && types[0] == EVT_OK && types[1] == EVT_ERXUDP);
+    CHECK(reader.discarded() == noise.size() + 2);
+
+    serial.close();
+    close(slave);
+    close(master);
+}
+
+int main()
+{
+    test_erxudp();
+    test_epandesc();
+    test_reader_overflow();
+    return check_result();
+}
@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "../event/skevents.h"
+#include "../echonet/reading.h"
+#include "check.h"
+
+namespace {
+
+const char IPV6[] = "FE80:0000:0000:0000:021C:6400:030C:12A4";
+
+CReading make_reading()
+{
+    CReading reading;
+    reading.time = 1700000000123LL;
+    reading.node = { 0xFE, 0x80, 0, 0, 0, 0, 0, 0, 0x02, 0x1C, 0x64, 0x00, 0x03, 0x0C, 0x12, 0xA4 };
+    reading.eoj = EOJ_SMART_METER;
+    reading.epc = EPC_INSTANT_POWER;
+    reading.edt = { 0x00, 0x00, 0x01, 0xF4 };
+    reading.value = 500;
+    return reading;
+}
+
+CSkEventDispatcher::ptr_type parse(const std::string &line)
+{
+    std::vector<char> buf(line.begin(), line.end());
+    CSkEventDispatcher::ptr_type ev;
+    long next_pos = 0;
+    if (CSkEventDispatcher::parse(buf, 0, buf.size(), ev, next_pos) != EV_MATCHED) {
+        CHECK_FAIL(("cannot parse " + line).c_str());
+        return nullptr;
+    }
+    return ev;
+}
+
+std::string text(const COutputBuffer &out)
+{
+    return std::string(out.data(), out.size());
+}
+
+std::vector<uint8_t> bytes(const COutputBuffer &out)
+{
+    return std::vector<uint8_t>((const uint8_t *)out.data(), (const uint8_t *)out.data() + out.size());
+}
+
+}
+
+static void test_reading()
+{
+    CReading reading = make_reading();
+    COutputBuffer out;
+
+    CHECK(reading.serialize(out, FORMAT_JSON));
+    CHECK(text(out) == std::string("{\"event\":\"READING\",\"TIME\":1700000000123,\"NODE\":\"") + IPV6
+                       + "\",\"EOJ\":165889,\"EPC\":231,\"EDT\":\"000001F4\",\"VALUE\":500}");
+    out.clear();
+    CHECK(reading.serialize(out, FORMAT_CSV));
+    CHECK(text(out) == std::string("READING,1700000000123,") + IPV6 + ",165889,231,000001F4,500");
+
+    const std::vector<uint8_t> binary = {
+        0x2D, 0x00,                                         // length
+        0x80,                                               // READING_KIND
+        0x7B, 0x68, 0xE5, 0xCF, 0x8B, 0x01, 0x00, 0x00,     // time
+        0xFE, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,     // node
+        0x02, 0x1C, 0x64, 0x00, 0x03, 0x0C, 0x12, 0xA4,
+        0x01, 0x88, 0x02, 0x00,                             // eoj
+        0xE7,                                               // epc
+        0x04, 0x00, 0x00, 0x00, 0x01, 0xF4,                 // edt
+        0x01, 0xF4, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,   // value
+    };
+    out.clear();
+    CHECK(reading.serialize(out, FORMAT_BINARY));
+    CHECK(bytes(out) == binary);
+
+    // no value
+    reading.value.reset();
+    reading.edt.clear();
+    out.clear();
+    reading.serialize(out, FORMAT_JSON);
+    CHECK(text(out) == std::string("{\"event\":\"READING\",\"TIME\":1700000000123,\"NODE\":\"") + IPV6
+                       + "\",\"EOJ\":165889,\"EPC\":231,\"EDT\":\"\",\"VALUE\":null}");
+    out.clear();
+    reading.serialize(out, FORMAT_CSV);
+    CHECK(text(out) == std::string("READING,1700000000123,") + IPV6 + ",165889,231,,");
+    out.clear();
+    reading.serialize(out, FORMAT_BINARY);
+    CHECK(out.size() == 2 + 0x21 && (uint8_t)out.data()[0] == 0x21 && out.data()[1] == 0);
+    CHECK(out.data()[out.size() - 3] == 0 && out.data()[out.size() - 2] == 0 && out.data()[out.size() - 1] == 0);
+}
+
+static void test_events()
+{
+    auto rx = parse("ERXUDP FE80:0000:0000:0000:021C:6400:030C:12A4 FE80:0000:0000:0000:021D:1290:1234:5678 "
+                    "0E1A 0E1A 001C6400030C12A4 1 0012 1081000102880105FF017201E70400000370\r\n");
+    auto sent = parse("EVENT 21 FE80:0000:0000:0000:021C:6400:030C:12A4 0 02\r\n");
+    auto connected = parse("EVENT 25 FE80:0000:0000:0000:021C:6400:030C:12A4\r\n");
+    if (rx == nullptr || sent == nullptr || connected == nullptr) {
+        return;
+    }
+
+    COutputBuffer out;
+    rx->serialize(out, FORMAT_JSON);
+    CHECK(text(out) == std::string("{\"event\":\"ERXUDP\",\"SENDER\":\"") + IPV6
+                       + "\",\"DEST\":\"FE80:0000:0000:0000:021D:1290:1234:5678\",\"RPORT\":3610,\"LPORT\":3610,"
+                         "\"SENDERLLA\":\"001C6400030C12A4\",\"SECURED\":true,"
+                         "\"DATA\":\"1081000102880105FF017201E70400000370\"}");
+    out.clear();
+    rx->serialize(out, FORMAT_CSV);
+    CHECK(text(out) == std::string("ERXUDP,") + IPV6 + ",FE80:0000:0000:0000:021D:1290:1234:5678,3610,3610,"
+                       "001C6400030C12A4,1,1081000102880105FF017201E70400000370");
+
+    const std::vector<uint8_t> binary = {
+        0x42, 0x00,                                         // length
+        EVT_ERXUDP,
+        0xFE, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,     // sender
+        0x02, 0x1C, 0x64, 0x00, 0x03, 0x0C, 0x12, 0xA4,
+        0xFE, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,     // dest
+        0x02, 0x1D, 0x12, 0x90, 0x12, 0x34, 0x56, 0x78,
+        0x1A, 0x0E, 0x1A, 0x0E,                             // rport, lport
+        0xA4, 0x12, 0x0C, 0x03, 0x00, 0x64, 0x1C, 0x00,     // senderlla
+        0x01,                                               // secured
+        0x12, 0x00,                                         // data
+        0x10, 0x81, 0x00, 0x01, 0x02, 0x88, 0x01, 0x05, 0xFF,
+        0x01, 0x72, 0x01, 0xE7, 0x04, 0x00, 0x00, 0x03, 0x70,
+    };
+    out.clear();
+    rx->serialize(out, FORMAT_BINARY);
+    CHECK(bytes(out) == binary);
+
+    out.clear();
+    sent->serialize(out, FORMAT_JSON);
+    out.append('\n');
+    connected->serialize(out, FORMAT_JSON);
+    CHECK(text(out) == std::string("{\"event\":\"EVENT\",\"NUM\":33,\"SENDER\":\"") + IPV6 + "\",\"SIDE\":0,\"PARAM\":2}\n"
+                       + "{\"event\":\"EVENT\",\"NUM\":37,\"SENDER\":\"" + IPV6 + "\",\"SIDE\":null,\"PARAM\":null}");
+    out.clear();
+    sent->serialize(out, FORMAT_CSV);
+    out.append('\n');
+    connected->serialize(out, FORMAT_CSV);
+    CHECK(text(out) == std::string("EVENT,33,") + IPV6 + ",0,2\nEVENT,37," + IPV6 + ",,");
+
+    // optional fields are a presence byte, then the value
+    out.clear();
+    sent->serialize(out, FORMAT_BINARY);
+    connected->serialize(out, FORMAT_BINARY);
+    std::vector<uint8_t> expected = { 0x16, 0x00, EVT_EVENT, 0x21 };
+    expected.insert(expected.end(), binary.begin() + 3, binary.begin() + 19);
+    expected.insert(expected.end(), { 0x01, 0x00, 0x01, 0x02 });
+    expected.insert(expected.end(), { 0x14, 0x00, EVT_EVENT, 0x25 });
+    expected.insert(expected.end(), binary.begin() + 3, binary.begin() + 19);
+    expected.insert(expected.end(), { 0x00, 0x00 });
+    CHECK(bytes(out) == expected);
+}
+
+static void test_binary_limit()
+{
+    // 33 bytes besides the EDT without a value: the record is at the u16 limit with 65502
+    CReading reading = make_reading();
+    reading.value.reset();
+    reading.edt.assign(CBinaryFormat::MAX_RECORD - 33, 0xAA);
+
+    COutputBuffer out;
+    out.append("before");
+    CHECK(reading.serialize(out, FORMAT_BINARY));
+    CHECK(out.size() == 6 + 2 + CBinaryFormat::MAX_RECORD);
+    CHECK((uint8_t)out.data()[6] == 0xFF && (uint8_t)out.data()[7] == 0xFF);
+
+    // one more byte does not fit: nothing of it is left behind
+    reading.edt.push_back(0xAA);
+    out.clear();
+    out.append("before");
+    CHECK(!reading.serialize(out, FORMAT_BINARY));
+    CHECK(text(out) == "before");
+
+    // the text formats have no limit
+    CHECK(reading.serialize(out, FORMAT_CSV));
+    CHECK(out.size() > 6 + 2 * CBinaryFormat::MAX_RECORD);
+}
+
+int main()
+{
+    test_reading();
+    test_events();
+    test_binary_limit();
+    return check_result();
+}
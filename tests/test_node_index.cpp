@@ -0,0 +1,102 @@
+#include <stdio.h>
+#include <vector>
+
+#include "../echonet/node_index.h"
+#include "check.h"
+
+static void test_list()
+{
+    const std::vector<uint8_t> edt = { 0x04, 0x80, 0x81, 0xE7, 0xFF };
+    CEpcSet set;
+    CHECK(set.decode(edt.data(), (uint8_t)edt.size()));
+    CHECK(set.count() == 4);
+    CHECK(set.test(0x80) && set.test(0x81) && set.test(0xE7) && set.test(0xFF));
+    CHECK(!set.test(0x82) && !set.test(0xE8));
+
+    // EPCs below 0x80 are not properties and are ignored
+    const std::vector<uint8_t> low = { 0x02, 0x10, 0x80 };
+    CHECK(set.decode(low.data(), (uint8_t)low.size()));
+    CHECK(set.count() == 1 && set.test(0x80) && !set.test(0x10));
+
+    // the count says more than the EDT holds
+    CHECK(!set.decode(edt.data(), 4));
+    CHECK(set.count() == 0);
+    CHECK(!set.decode(edt.data(), 0));
+
+    const std::vector<uint8_t> empty = { 0x00 };
+    CHECK(set.decode(empty.data(), 1));
+    CHECK(set.count() == 0);
+}
+
+static void test_bitmap()
+{
+    // byte i, bit b stands for 0x80 + b * 16 + i
+    std::vector<uint8_t> edt(17, 0);
+    edt[0] = 16;
+    edt[1 + 0x0] |= 1 << 0;        // 0x80
+    edt[1 + 0x8] |= 1 << 0;        // 0x88
+    edt[1 + 0x7] |= 1 << 6;        // 0xE7
+    edt[1 + 0x0] |= 1 << 6;        // 0xE0
+    edt[1 + 0x3] |= 1 << 6;        // 0xE3
+    edt[1 + 0xD] |= 1 << 1;        // 0x9D
+    edt[1 + 0xE] |= 1 << 1;        // 0x9E
+    edt[1 + 0xF] |= 1 << 1;        // 0x9F
+    edt[1 + 0xA] |= 1 << 3;        // 0xBA
+    edt[1 + 0xF] |= 1 << 7;        // 0xFF
+    edt[1 + 0x0] |= 1 << 7;        // 0xF0
+    edt[1 + 0x1] |= 1 << 2;        // 0xA1
+    edt[1 + 0x2] |= 1 << 4;        // 0xC2
+    edt[1 + 0x3] |= 1 << 5;        // 0xD3
+    edt[1 + 0x4] |= 1 << 3;        // 0xB4
+    edt[1 + 0x5] |= 1 << 1;        // 0x95
+
+    CEpcSet set;
+    CHECK(set.decode(edt.data(), (uint8_t)edt.size()));
+    const uint8_t expected[] = { 0x80, 0x88, 0xE7, 0xE0, 0xE3, 0x9D, 0x9E, 0x9F,
+                                 0xBA, 0xFF, 0xF0, 0xA1, 0xC2, 0xD3, 0xB4, 0x95 };
+    CHECK(set.count() == 16);
+    for (uint8_t epc : expected) {
+        CHECK(set.test(epc));
+    }
+    CHECK(!set.test(0x81) && !set.test(0xE8) && !set.test(0x90));
+
+    // all bits set is every EPC
+    std::vector<uint8_t> full(17, 0xFF);
+    full[0] = 128;
+    CHECK(set.decode(full.data(), (uint8_t)full.size()));
+    CHECK(set.count() == 128);
+
+    // a bitmap must be 16 bytes
+    CHECK(!set.decode(edt.data(), 16));
+}
+
+static void test_index()
+{
+    CNodeIndex index;
+    node_addr_t node {};
+    node[0] = 0xFE;
+
+    // D5: two instances
+    const std::vector<uint8_t> instances = { 0x02, 0x02, 0x88, 0x01, 0x02, 0x79, 0x01 };
+    CHECK(index.add_instances(node, instances.data(), (uint8_t)instances.size()) == 3);
+    CHECK(index.add_instances(node, instances.data(), (uint8_t)instances.size()) == 0);
+    CHECK(index.find(node, EOJ_SMART_METER) != nullptr);
+    CHECK(index.find(node, EOJ_NODE_PROFILE) != nullptr);
+    CHECK(index.add_instances(node, instances.data(), 6) == 0);
+
+    // unknown maps do not rule anything out, known ones do
+    CHECK(index.may_support(node, EOJ_SMART_METER, MAP_GET, 0xE7));
+    const std::vector<uint8_t> get_map = { 0x03, 0x80, 0xE0, 0xE7 };
+    CHECK(index.set_map(node, EOJ_SMART_METER, EPC_GET_MAP, get_map.data(), (uint8_t)get_map.size()));
+    CHECK(index.may_support(node, EOJ_SMART_METER, MAP_GET, 0xE7));
+    CHECK(!index.may_support(node, EOJ_SMART_METER, MAP_GET, 0xE8));
+    CHECK(index.may_support(node, EOJ_SMART_METER, MAP_SET, 0xE8));
+}
+
+int main()
+{
+    test_list();
+    test_bitmap();
+    test_index();
+    return check_result();
+}
@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <vector>
+
+#include "../echonet/requester.h"
+#include "check.h"
+
+namespace {
+
+// the requester takes the time from its caller, the tests pass it in
+struct CMeter
+{
+    node_addr_t node {};
+    CPropertyCache cache;
+    std::vector<std::vector<uint8_t>> sent;
+    CSendResult result = SEND_OK;
+    CEchonetRequester requester;
+
+    CMeter()
+        : requester(cache, [this](const node_addr_t &, const std::vector<uint8_t> &frame) {
+              if (result == SEND_OK) {
+                  sent.push_back(frame);
+              }
+              return result;
+          })
+    {
+        node[0] = 0xFE;
+        node[1] = 0x80;
+    }
+
+    // answers sent[index] from the smart meter
+    bool respond(size_t index, uint8_t esv, const std::vector<std::pair<uint8_t, std::vector<uint8_t>>> &props,
+                 CPropertyCache::msec_t now)
+    {
+        const auto &req = sent[index];
+        std::vector<uint8_t> frame = { 0x10, 0x81, req[2], req[3], 0x02, 0x88, 0x01, 0x05, 0xFF, 0x01, esv,
+                                       (uint8_t)props.size() };
+        for (const auto &prop : props) {
+            frame.push_back(prop.first);
+            frame.push_back((uint8_t)prop.second.size());
+            frame.insert(frame.end(), prop.second.begin(), prop.second.end());
+        }
+        return requester.handle(node, frame, now);
+    }
+};
+
+// the EPCs asked for by a Get frame
+std::vector<uint8_t> epcs_of(const std::vector<uint8_t> &frame)
+{
+    std::vector<uint8_t> epcs;
+    for (size_t i = 0; i < frame[11]; ++i) {
+        epcs.push_back(frame[12 + i * 2]);
+    }
+    return epcs;
+}
+
+struct CResult
+{
+    int calls = 0;
+    CRequestStatus status = REQ_TIMEOUT;
+    std::vector<uint8_t> edt;
+
+    CEchonetRequester::callback_type callback()
+    {
+        return [this](CRequestStatus s, const uint8_t *data, uint8_t pdc) {
+            ++calls;
+            status = s;
+            edt.assign(data, data + pdc);
+        };
+    }
+};
+
+const std::vector<uint8_t> POWER = { 0x00, 0x00, 0x01, 0xF4 };
+
+}
+
+static void test_cache()
+{
+    CMeter meter;
+    CResult first;
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_POWER, first.callback(), 0);
+    CHECK(meter.requester.flush(0) == 1);
+    CHECK(meter.respond(0, ESV_GET_RES, { { EPC_INSTANT_POWER, POWER } }, 100));
+    CHECK(first.calls == 1 && first.status == REQ_OK && first.edt == POWER);
+
+    // fresh until stored_at + TTL, answered without a frame
+    const auto ttl = meter.cache.get_ttl(EPC_INSTANT_POWER);
+    CResult cached;
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_POWER, cached.callback(), 100 + ttl - 1);
+    CHECK(cached.calls == 1 && cached.status == REQ_OK && cached.edt == POWER);
+    CHECK(meter.requester.queued() == 0);
+
+    CResult expired;
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_POWER, expired.callback(), 100 + ttl);
+    CHECK(expired.calls == 0 && meter.requester.queued() == 1);
+    CHECK(meter.requester.flush(100 + ttl) == 1 && meter.sent.size() == 2);
+
+    // history and its day selection are never served from the cache
+    for (uint8_t epc : { EPC_HISTORY_NORMAL, EPC_HISTORY_REVERSE, EPC_HISTORY_DAY, EPC_HISTORY2, EPC_HISTORY2_TIME }) {
+        CPropertyKey key { meter.node, EOJ_SMART_METER.code(), epc };
+        meter.cache.store(key, POWER.data(), (uint8_t)POWER.size(), 0);
+        CHECK(meter.cache.find(key, 0) == nullptr);
+    }
+}
+
+static void test_coalesce()
+{
+    CMeter meter;
+    std::vector<CResult> results(20);
+    for (uint8_t i = 0; i < 3; ++i) {
+        meter.requester.get(meter.node, EOJ_SMART_METER, 0xE0 + i, results[i].callback(), 0);
+    }
+    CHECK(meter.requester.queued() == 3);
+    CHECK(meter.requester.flush(0) == 1);
+    CHECK(meter.sent.size() == 1 && meter.sent[0][10] == ESV_GET);
+    CHECK(epcs_of(meter.sent[0]) == (std::vector<uint8_t> { 0xE0, 0xE1, 0xE2 }));
+
+    // one Get answers every waiter, EPCs left out are not available
+    CHECK(meter.respond(0, ESV_GET_RES, { { 0xE0, POWER }, { 0xE2, POWER } }, 0));
+    CHECK(results[0].status == REQ_OK && results[2].status == REQ_OK);
+    CHECK(results[1].calls == 1 && results[1].status == REQ_NOT_AVAILABLE);
+    CHECK(meter.requester.in_flight() == 0);
+
+    // more than MAX_EPC_PER_GET EPCs are split, other objects get their own Get
+    meter.sent.clear();
+    for (uint8_t i = 0; i < 20; ++i) {
+        meter.requester.get(meter.node, EOJ_SMART_METER, 0x80 + i, results[i].callback(), 0);
+    }
+    meter.requester.get(meter.node, EOJ_NODE_PROFILE, 0x80, results[0].callback(), 0);
+    CHECK(meter.requester.flush(0) == 3);
+    CHECK(meter.sent.size() == 3 && meter.requester.in_flight() == 3);
+    if (meter.sent.size() != 3) {
+        return;
+    }
+    CHECK(epcs_of(meter.sent[0]).size() == CEchonetRequester::MAX_EPC_PER_GET);
+    CHECK(epcs_of(meter.sent[0]).front() == 0x80 && epcs_of(meter.sent[0]).back() == 0x8F);
+    CHECK(epcs_of(meter.sent[1]) == (std::vector<uint8_t> { 0x90, 0x91, 0x92, 0x93 }));
+    CHECK(epcs_of(meter.sent[2]) == std::vector<uint8_t> { 0x80 });
+    CHECK(meter.sent[2][7] == 0x0E && meter.sent[2][8] == 0xF0);
+}
+
+static void test_in_flight()
+{
+    CMeter meter;
+    CResult first;
+    CResult second;
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_POWER, first.callback(), 0);
+    CHECK(meter.requester.flush(0) == 1);
+
+    // asked again while the Get is out: waits for it, nothing new is sent
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_POWER, second.callback(), 10);
+    CHECK(meter.requester.queued() == 0);
+    CHECK(meter.requester.flush(10) == 0 && meter.sent.size() == 1);
+
+    CHECK(meter.respond(0, ESV_GET_RES, { { EPC_INSTANT_POWER, POWER } }, 20));
+    CHECK(first.calls == 1 && first.edt == POWER);
+    CHECK(second.calls == 1 && second.status == REQ_OK && second.edt == POWER);
+
+    // unanswered, both waiters time out together
+    CResult late[2];
+    meter.requester.set_timeout(1000);
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_CURRENT, late[0].callback(), 100);
+    CHECK(meter.requester.flush(100) == 1);
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_CURRENT, late[1].callback(), 200);
+    meter.requester.expire(1099);
+    CHECK(late[0].calls == 0);
+    meter.requester.expire(1100);
+    CHECK(late[0].calls == 1 && late[0].status == REQ_TIMEOUT);
+    CHECK(late[1].calls == 1 && late[1].status == REQ_TIMEOUT);
+}
+
+static void test_unanswered()
+{
+    CMeter meter;
+    CResult result;
+    CHECK(meter.requester.unanswered_since() == -1);
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_POWER, result.callback(), 100);
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_CURRENT, result.callback(), 100);
+    CHECK(meter.requester.unanswered_since() == -1);
+    CHECK(meter.requester.flush(1000) == 1);
+    CHECK(meter.requester.unanswered_since() == 1000);
+
+    // answered: nothing is owed, a request after a quiet spell starts afresh
+    CHECK(meter.respond(0, ESV_GET_RES, { { EPC_INSTANT_POWER, POWER } }, 2000));
+    CHECK(meter.requester.unanswered_since() == -1);
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_CUMULATIVE_NORMAL, result.callback(), 60000);
+    CHECK(meter.requester.flush(60000) == 1);
+    CHECK(meter.requester.unanswered_since() == 60000);
+
+    // timing out is not an answer, later sends keep the first time
+    meter.requester.set_timeout(1000);
+    meter.requester.expire(80000);
+    CHECK(meter.requester.in_flight() == 0 && meter.requester.unanswered_since() == 60000);
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_CUMULATIVE_REVERSE, result.callback(), 90000);
+    meter.requester.get(meter.node, EOJ_NODE_PROFILE, 0x80, result.callback(), 90000);
+    CHECK(meter.requester.flush(90000) == 2);
+    CHECK(meter.requester.unanswered_since() == 60000);
+
+    // one answer of two restarts the clock for the other
+    CHECK(meter.respond(2, ESV_GET_RES, { { EPC_CUMULATIVE_REVERSE, POWER } }, 95000));
+    CHECK(meter.requester.in_flight() == 1 && meter.requester.unanswered_since() == 95000);
+}
+
+static void test_resume()
+{
+    CMeter meter;
+    meter.requester.set_timeout(1000);
+    const uint8_t one = 0x01;
+    const CEchonetProperty day { EPC_HISTORY_DAY, 1, &one };
+    int responses = 0;
+    uint8_t esv = 0;
+    CHECK(meter.requester.transact(meter.node, EOJ_SMART_METER, ESV_SETC, &day, 1, [&](const CEchonetFrame *frame) {
+        ++responses;
+        esv = frame != nullptr ? frame->esv : 0;
+    }, 0));
+    CResult power;
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_POWER, power.callback(), 0);
+    CHECK(meter.requester.flush(0) == 1);
+    CHECK(meter.sent.size() == 2);
+
+    // the link goes down: nothing is sent and nothing times out
+    meter.requester.suspend();
+    CHECK(!meter.requester.transact(meter.node, EOJ_SMART_METER, ESV_SETC, &day, 1, nullptr, 0));
+    CHECK(meter.requester.flush(500) == 0);
+    meter.requester.expire(5000);
+    CHECK(responses == 0 && power.calls == 0);
+
+    // the parked Set goes out again as it was, before the Get asked again
+    meter.requester.resume();
+    CHECK(meter.requester.flush(5000) == 2);
+    CHECK(meter.sent.size() == 4);
+    if (meter.sent.size() != 4) {
+        return;
+    }
+    CHECK(meter.sent[2] == meter.sent[0]);
+    CHECK(epcs_of(meter.sent[3]) == std::vector<uint8_t> { EPC_INSTANT_POWER });
+
+    // given a fresh deadline
+    meter.requester.expire(5999);
+    CHECK(responses == 0);
+    CHECK(meter.respond(2, ESV_SET_RES, { { EPC_HISTORY_DAY, {} } }, 5100));
+    CHECK(responses == 1 && esv == ESV_SET_RES);
+    CHECK(meter.respond(3, ESV_GET_RES, { { EPC_INSTANT_POWER, POWER } }, 5100));
+    CHECK(power.calls == 1 && power.status == REQ_OK);
+}
+
+static void test_deferred()
+{
+    CMeter meter;
+    CResult result;
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_POWER, result.callback(), 0);
+
+    // out of budget: kept, not failed
+    meter.result = SEND_DEFERRED;
+    CHECK(meter.requester.flush(0) == 0);
+    CHECK(result.calls == 0 && meter.requester.queued() == 1);
+
+    meter.result = SEND_OK;
+    CHECK(meter.requester.flush(100) == 1);
+    CHECK(meter.respond(0, ESV_GET_RES, { { EPC_INSTANT_POWER, POWER } }, 200));
+    CHECK(result.calls == 1 && result.status == REQ_OK);
+
+    CResult failed;
+    meter.requester.get(meter.node, EOJ_SMART_METER, EPC_INSTANT_CURRENT, failed.callback(), 300);
+    meter.result = SEND_FAILED;
+    CHECK(meter.requester.flush(300) == 0);
+    CHECK(failed.calls == 1 && failed.status == REQ_SEND_FAILED);
+    CHECK(meter.requester.queued() == 0 && meter.requester.in_flight() == 0);
+}
+
+int main()
+{
+    test_cache();
+    test_coalesce();
+    test_in_flight();
+    test_unanswered();
+    test_resume();
+    test_deferred();
+    return check_result();
+}
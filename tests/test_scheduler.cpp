@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <vector>
+
+#include "../scheduler/poll_scheduler.h"
+#include "check.h"
+
+namespace {
+
+using msec_t = CTxBudget::msec_t;
+
+const msec_t SECOND = 1000;
+const msec_t MINUTE = 60 * SECOND;
+const msec_t HOUR = 60 * MINUTE;
+
+struct CMeter
+{
+    node_addr_t node {};
+    CPropertyCache cache;
+    int sent = 0;
+    CEchonetRequester requester;
+
+    CMeter()
+        : requester(cache, [this](const node_addr_t &, const std::vector<uint8_t> &) {
+              ++sent;
+              return SEND_OK;
+          })
+    {
+        node[0] = 0xFE;
+        node[1] = 0x80;
+    }
+
+    CPollSpec spec(uint8_t epc, CPollPriority priority, msec_t min_interval, msec_t max_interval) const
+    {
+        return CPollSpec { node, EOJ_SMART_METER, { epc }, priority, min_interval, max_interval, nullptr };
+    }
+};
+
+}
+
+static void test_window()
+{
+    CTxBudget budget;
+    const CTxBudget::usec_t BUDGET = budget.get_budget();
+    CHECK(budget.get_window() == HOUR && BUDGET == 360LL * 1000 * 1000);
+
+    budget.record(200 * 1000 * 1000, 0);
+    budget.record(100 * 1000 * 1000, 30 * MINUTE);
+    CHECK(budget.can_send(60 * 1000 * 1000, 30 * MINUTE));
+    CHECK(!budget.can_send(60 * 1000 * 1000 + 1, 30 * MINUTE));
+
+    // a smaller share is refused first
+    CHECK(!budget.can_send(1, 30 * MINUTE, 0.8));
+
+    // the first send leaves the window exactly an hour later
+    CHECK(budget.used(HOUR - 1) == 300 * 1000 * 1000);
+    CHECK(budget.used(HOUR) == 100 * 1000 * 1000);
+    CHECK(budget.can_send(260 * 1000 * 1000, HOUR));
+    CHECK(budget.used(HOUR + 30 * MINUTE) == 0);
+    CHECK(budget.utilization(HOUR + 30 * MINUTE) == 0);
+}
+
+static void test_penalty()
+{
+    CTxBudget budget;
+    CHECK(!budget.is_blocked(0));
+
+    // 30 s, doubling up to 15 min
+    const msec_t expected[] = { 30 * SECOND, MINUTE, 2 * MINUTE, 4 * MINUTE, 8 * MINUTE, 15 * MINUTE, 15 * MINUTE };
+    msec_t now = 0;
+    for (msec_t penalty : expected) {
+        budget.penalize(now);
+        CHECK(budget.is_blocked(now + penalty - 1));
+        CHECK(!budget.can_send(1, now + penalty - 1));
+        CHECK(!budget.is_blocked(now + penalty));
+        CHECK(budget.can_send(1, now + penalty));
+        now += penalty;
+    }
+
+    // a send went through: back to the shortest penalty
+    budget.clear_penalty();
+    budget.penalize(now);
+    CHECK(budget.is_blocked(now + 30 * SECOND - 1) && !budget.is_blocked(now + 30 * SECOND));
+}
+
+static void test_adapt()
+{
+    // 7.7 ms of airtime per one-EPC Get, the budget sustains 1 usec/msec at the 0.9 target
+    CMeter meter;
+    CTxBudget budget(HOUR, 4 * 1000 * 1000);
+    CPollScheduler scheduler(meter.requester, budget);
+    CHECK(CTxBudget::estimate_airtime(14) == 7700);
+
+    int instant = scheduler.add(meter.spec(EPC_INSTANT_POWER, POLL_INSTANT, 10 * SECOND, MINUTE), 0);
+    CHECK(scheduler.get_interval(instant) == 10 * SECOND);
+    int history = scheduler.add(meter.spec(EPC_HISTORY_NORMAL, POLL_HISTORY, 10 * SECOND, 10 * MINUTE), 0);
+
+    // the history poll gives way alone: 0.77 + 7700 / interval == 1.0
+    CHECK(scheduler.get_interval(instant) == 10 * SECOND);
+    msec_t interval = scheduler.get_interval(history);
+    CHECK(interval >= 33470 && interval <= 33490);
+
+    // three quarters of that: history and cumulative go to their max_interval
+    // before instant stretches
+    CTxBudget tight(HOUR, 3 * 1000 * 1000);
+    CPollScheduler squeezed(meter.requester, tight);
+    instant = squeezed.add(meter.spec(EPC_INSTANT_POWER, POLL_INSTANT, 10 * SECOND, MINUTE), 0);
+    int cumulative = squeezed.add(meter.spec(EPC_CUMULATIVE_NORMAL, POLL_CUMULATIVE, 10 * SECOND, 20 * SECOND), 0);
+    history = squeezed.add(meter.spec(EPC_HISTORY_NORMAL, POLL_HISTORY, 10 * SECOND, 10 * MINUTE), 0);
+    CHECK(squeezed.get_interval(history) == 10 * MINUTE);
+    CHECK(squeezed.get_interval(cumulative) == 20 * SECOND);
+    interval = squeezed.get_interval(instant);
+    CHECK(interval > 10 * SECOND && interval < MINUTE);
+
+    // more than the budget allows at every max_interval: all of them wait at their max
+    CTxBudget none(HOUR, 1000);
+    CPollScheduler starved(meter.requester, none);
+    instant = starved.add(meter.spec(EPC_INSTANT_POWER, POLL_INSTANT, 10 * SECOND, MINUTE), 0);
+    CHECK(starved.get_interval(instant) == MINUTE);
+}
+
+static void test_tx_limit()
+{
+    CMeter meter;
+    CTxBudget budget;
+    CPollScheduler scheduler(meter.requester, budget);
+    scheduler.add(meter.spec(EPC_INSTANT_POWER, POLL_INSTANT, 10 * SECOND, MINUTE), 0);
+    const double start = scheduler.get_target();
+    CHECK(start == 0.9);
+
+    scheduler.on_tx_limit(0);
+    CHECK(scheduler.get_target() == start / 2);
+    CHECK(budget.is_blocked(0));
+    CHECK(scheduler.run(10 * SECOND) == 0);
+
+    // reports while the budget holds back are the same episode
+    scheduler.on_tx_limit(1 * SECOND);
+    scheduler.on_tx_limit(29 * SECOND);
+    CHECK(scheduler.get_target() == start / 2);
+    CHECK(!budget.is_blocked(30 * SECOND));
+
+    // a new episode halves again and doubles the penalty
+    scheduler.on_tx_limit(30 * SECOND);
+    CHECK(scheduler.get_target() == start / 4);
+    CHECK(budget.is_blocked(90 * SECOND - 1) && !budget.is_blocked(90 * SECOND));
+
+    // no raise until QUIET_PERIOD after the last limit, then one step per RAISE_PERIOD
+    scheduler.on_sent(30 * SECOND + 10 * MINUTE - 1);
+    CHECK(scheduler.get_target() == start / 4);
+    scheduler.on_sent(30 * SECOND + 10 * MINUTE);
+    const double raised = scheduler.get_target();
+    CHECK(raised > start / 4);
+    scheduler.on_sent(30 * SECOND + 10 * MINUTE + 1);
+    CHECK(scheduler.get_target() == raised);
+    scheduler.on_sent(30 * SECOND + 11 * MINUTE);
+    CHECK(scheduler.get_target() > raised);
+
+    // polls go out again once the penalty is over
+    CHECK(scheduler.run(3 * MINUTE) == 1);
+    CHECK(meter.requester.flush(3 * MINUTE) == 1 && meter.sent == 1);
+}
+
+int main()
+{
+    test_window();
+    test_penalty();
+    test_adapt();
+    test_tx_limit();
+    return check_result();
+}
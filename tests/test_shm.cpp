@@ -0,0 +1,239 @@
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <thread>
+
+#include "../shm/shm_publisher.h"
+#include "../shm/shm_reader.h"
+#include "check.h"
+
+static char socket_path[64];
+
+// connect() waits for the memfd, so the publisher serves from a second thread
+static int connect_reader(CShmPublisher &publisher, CShmReader &reader)
+{
+    std::thread server([&publisher] {
+        for (int i = 0; i < 2000 && publisher.serve() == 0; ++i) {
+            usleep(1000);
+        }
+    });
+    int ret = reader.connect(socket_path);
+    server.join();
+    return ret;
+}
+
+// hands out fds the way a publisher would, whatever they hold
+static int connect_fake(const int *fds, int nfds, CShmReader &reader)
+{
+    int sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+    unlink(socket_path);
+    if (sock < 0 || bind(sock, (sockaddr *)&addr, sizeof(addr)) < 0 || listen(sock, 1) < 0) {
+        CHECK_FAIL("cannot listen");
+        return 0;
+    }
+
+    std::thread server([sock, fds, nfds] {
+        int client = accept(sock, nullptr, nullptr);
+        char byte = 0;
+        iovec iov = { &byte, 1 };
+        union {
+            cmsghdr align;
+            char buf[CMSG_SPACE(2 * sizeof(int))];
+        } control;
+        memset(&control, 0, sizeof(control));
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(nfds * sizeof(int));
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(nfds * sizeof(int));
+        memcpy(CMSG_DATA(cmsg), fds, nfds * sizeof(int));
+        sendmsg(client, &msg, MSG_NOSIGNAL);
+        close(client);
+    });
+    int ret = reader.connect(socket_path);
+    server.join();
+    close(sock);
+    unlink(socket_path);
+    return ret;
+}
+
+static int make_memfd(const void *data, size_t length, size_t size)
+{
+    int fd = memfd_create("test_shm", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, size) < 0 || pwrite(fd, data, length, 0) != (ssize_t)length) {
+        CHECK_FAIL("cannot create a memfd");
+    }
+    return fd;
+}
+
+static void test_roundtrip()
+{
+    CShmPublisher publisher;
+    CHECK(publisher.create("test_shm", 8, 64) == 0);
+    CHECK(publisher.listen(socket_path) == 0);
+    CShmReader reader;
+    CHECK(connect_reader(publisher, reader) == 0);
+
+    const char *text[] = { "first", "second", "third" };
+    for (uint16_t i = 0; i < 3; ++i) {
+        CHECK(publisher.publish(i + 1, text[i], strlen(text[i])) == 0);
+    }
+
+    CShmRecord rec;
+    for (uint16_t i = 0; i < 3; ++i) {
+        CHECK(reader.next(rec, 0) == SHM_READ_OK);
+        CHECK(rec.seq == i && rec.type == i + 1);
+        CHECK(rec.length == strlen(text[i]) && memcmp(rec.data, text[i], rec.length) == 0);
+        CHECK(reader.validate(rec));
+    }
+    CHECK(reader.next(rec, 10) == SHM_READ_TIMEOUT);
+    CHECK(reader.lost() == 0);
+
+    // too big for a slot: dropped on the writer's side, never seen
+    char big[64] = {};
+    CHECK(publisher.publish(9, big, sizeof(big)) == E_SHM_INVALID_ARG);
+    CHECK(publisher.dropped() == 1 && publisher.published() == 3);
+}
+
+static void test_wake()
+{
+    CShmPublisher publisher;
+    CHECK(publisher.create("test_shm", 8, 64) == 0);
+    CHECK(publisher.listen(socket_path) == 0);
+    CShmReader reader;
+    CHECK(connect_reader(publisher, reader) == 0);
+    CHECK(publisher.waiters() == 0);
+
+    CShmReadResult result = SHM_READ_ERROR;
+    CShmRecord rec;
+    std::thread waiter([&] { result = reader.next(rec, 5000); });
+    for (int i = 0; i < 2000 && publisher.waiters() == 0; ++i) {
+        usleep(1000);
+    }
+    CHECK(publisher.waiters() == 1);
+    CHECK(publisher.publish(1, "x", 1) == 0);
+    waiter.join();
+    CHECK(result == SHM_READ_OK && rec.seq == 0);
+    CHECK(publisher.waiters() == 0);
+}
+
+static void test_lost()
+{
+    CShmPublisher publisher;
+    CHECK(publisher.create("test_shm", 4, 64) == 0);
+    CHECK(publisher.listen(socket_path) == 0);
+    CShmReader reader;
+    CHECK(connect_reader(publisher, reader) == 0);
+
+    // 10 records into 4 slots: the reader only finds the last 4
+    for (uint32_t i = 0; i < 10; ++i) {
+        CHECK(publisher.publish(1, &i, sizeof(i)) == 0);
+    }
+    CShmRecord rec;
+    for (uint32_t i = 6; i < 10; ++i) {
+        CHECK(reader.next(rec, 0) == SHM_READ_OK);
+        uint32_t value;
+        memcpy(&value, rec.data, sizeof(value));
+        CHECK(rec.seq == i && value == i);
+    }
+    CHECK(reader.lost() == 6);
+
+    // overwritten while still held
+    for (uint32_t i = 0; i < 4; ++i) {
+        CHECK(publisher.publish(1, &i, sizeof(i)) == 0);
+    }
+    CHECK(!reader.validate(rec));
+
+    // a reader which starts late begins at the oldest record kept
+    CShmReader late;
+    CHECK(connect_reader(publisher, late) == 0);
+    CHECK(late.next(rec, 0) == SHM_READ_OK && rec.seq == 10);
+    CHECK(late.lost() == 0);
+    late.seek_to_end();
+    CHECK(late.next(rec, 0) == SHM_READ_TIMEOUT);
+}
+
+static void test_geometry()
+{
+    CHECK(shm_valid_geometry(4, 64));
+    CHECK(!shm_valid_geometry(0, 64));
+    CHECK(!shm_valid_geometry(3, 64));
+    CHECK(!shm_valid_geometry(4, sizeof(CShmSlot)));
+    CHECK(!shm_valid_geometry(4, 60));
+
+    CShmPublisher publisher;
+    CHECK(publisher.create("test_shm", 3, 64) == E_SHM_INVALID_ARG);
+    CHECK(publisher.create("test_shm", 4, 60) == E_SHM_INVALID_ARG);
+    CHECK(!publisher.is_opened());
+
+    CShmWaiters waiters = {};
+    CShmRingHeader header = {};
+    header.magic = SHM_RING_MAGIC;
+    header.version = SHM_RING_VERSION;
+    header.slot_count = 4;
+    header.slot_size = 64;
+    const size_t size = shm_ring_size(4, 64);
+
+    // a well-formed ring is accepted
+    int fds[2] = { make_memfd(&header, sizeof(header), size), make_memfd(&waiters, sizeof(waiters), sizeof(waiters)) };
+    CShmReader reader;
+    CHECK(connect_fake(fds, 2, reader) == 0);
+    reader.close();
+    close(fds[0]);
+
+    const struct {
+        uint32_t slot_count;
+        uint32_t slot_size;
+        uint32_t version;
+        size_t size;
+    } bad[] = {
+        { 3, 64, SHM_RING_VERSION, size },
+        { 4, 60, SHM_RING_VERSION, size },
+        { 0, 64, SHM_RING_VERSION, size },
+        { 8, 64, SHM_RING_VERSION, size },              // larger than the memfd
+        { 4, 64, SHM_RING_VERSION - 1, size },
+        { 4, 64, SHM_RING_VERSION, sizeof(header) - 1 },
+    };
+    for (const auto &b : bad) {
+        header.slot_count = b.slot_count;
+        header.slot_size = b.slot_size;
+        header.version = b.version;
+        fds[0] = make_memfd(&header, std::min(sizeof(header), b.size), b.size);
+        CHECK(connect_fake(fds, 2, reader) == E_SHM_BAD_FORMAT);
+        CHECK(!reader.is_opened());
+        close(fds[0]);
+    }
+
+    // a version 1 publisher sends no waiter count
+    header.slot_count = 4;
+    header.slot_size = 64;
+    header.version = SHM_RING_VERSION;
+    fds[0] = make_memfd(&header, sizeof(header), size);
+    CHECK(connect_fake(fds, 1, reader) == E_SHM_BAD_FORMAT);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main()
+{
+    snprintf(socket_path, sizeof(socket_path), "/tmp/test_shm-%d.sock", (int)getpid());
+    test_roundtrip();
+    test_wake();
+    test_lost();
+    test_geometry();
+    unlink(socket_path);
+    return check_result();
+}